@@ -0,0 +1,327 @@
+// headless benchmark driver for the Voro wrapper: replays a script of editor operations against a native build
+// and reports per-op latency percentiles, so the hot paths can be profiled outside the browser.
+//
+// usage: voro_bench [-n cells] [-s seed] [script_file | -]
+//
+// script format is one op per line ('#' starts a comment):
+//   cells N [fill]          reset the diagram to N random cells, with the given fraction (default .5) turned on
+//   build_container         (re)build the voro++ container from the current cells
+//   reorder                 renumber the cells in spatial order (reorder_spatially)
+//   threads N               max threads for gl_build (0 = all hardware threads, the default; 1 = serial)
+//   indexed 0|1             turn off/on indexed gl buffers (rebuilding them if they are already built)
+//   gl_build [reps]         build the gl buffers for the whole diagram
+//   palette N               set a palette of N random colors (turns on vertex colors)
+//   add N                   N add_cell calls at random positions
+//   add_batch N [K]         N add_cells calls, each adding K (default 1000) cells at random positions
+//   move N [K] [dist]       N move_cells calls, each moving K (default 1) random cells up to dist (default .05) away
+//   move_each N [K] [dist]  N batches of K (default 1) single move_cell calls on a cluster of nearby cells, applied with one gl_flush
+//   toggle N [K]            N batches of K (default 1) toggle_cell calls on a cluster of nearby cells, applied with one gl_flush
+//   delete N                N delete_cell calls on random cells
+//   export N                N export_index_mesh calls
+// if no script is given, a default script is run with the -n cell count.
+// edit ops are timed including the gl_flush that applies them, since the renderer reads the gl buffers after every edit.
+// upload_kb is the mean size of the gl buffer ranges each call dirtied (gl_dirty_*_range), i.e. what the renderer has to re-upload.
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <random>
+
+#include "../vorowrap.hh"
+#include "../glm/common.hpp"
+
+static const char *default_script =
+    "cells $N\n"
+    "gl_build 3\n"
+    "toggle 1000\n"
+    "move 200 1 .05\n"
+    "move 20 500 .05\n"
+    "move_each 100 8 .05\n"
+    "toggle 200 8\n"
+    "add 1000\n"
+    "delete 1000\n"
+    "export 3\n";
+
+struct OpTimes {
+    string name;
+    vector<double> us; // latency of each call, in microseconds
+    double upload_bytes; // total size of the gl buffer ranges the calls dirtied (what a renderer would re-upload)
+    
+    OpTimes() : upload_bytes(0) {}
+};
+
+struct Bench {
+    Voro *voro;
+    mt19937 rng;
+    vector<OpTimes> ops; // kept in order of first appearance
+    
+    Bench(unsigned seed) : voro(0), rng(seed) {
+        srand(seed); // Voro's jitter() uses rand()
+    }
+    ~Bench() {
+        delete voro;
+    }
+    
+    float randf(float lo, float hi) {
+        return uniform_real_distribution<float>(lo, hi)(rng);
+    }
+    int randi(int n) { // uniform in [0,n)
+        return uniform_int_distribution<int>(0, n-1)(rng);
+    }
+    glm::vec3 rand_pt() {
+        return glm::vec3(randf(-9.99f, 9.99f), randf(-9.99f, 9.99f), randf(-9.99f, 9.99f));
+    }
+    
+    // a random cell and its k-1 nearest cells, like the groups of cells the editor's symmetry modes and undo stack edit together
+    vector<int> pick_cluster(int k) {
+        int n = voro->cell_count();
+        k = min(k, n);
+        glm::vec3 center = voro->cell_pos(randi(n));
+        vector<pair<float, int>> by_dist(n);
+        for (int i=0; i<n; i++) {
+            glm::vec3 d = voro->cell_pos(i) - center;
+            by_dist[i] = make_pair(glm::dot(d, d), i);
+        }
+        partial_sort(by_dist.begin(), by_dist.begin()+k, by_dist.end());
+        vector<int> cluster;
+        for (int i=0; i<k; i++) {
+            cluster.push_back(by_dist[i].second);
+        }
+        return cluster;
+    }
+    
+    OpTimes &times(const string &name) {
+        for (auto &op : ops) {
+            if (op.name == name) return op;
+        }
+        ops.push_back(OpTimes());
+        ops.back().name = name;
+        return ops.back();
+    }
+    
+    double dirty_upload_bytes() {
+        if (!voro || !voro->gl_is_live()) return 0;
+        GLRange tris = voro->gl_dirty_tri_range(), verts = voro->gl_dirty_vert_range(), sites = voro->gl_dirty_site_range();
+        double vert_bytes = voro->has_colors() ? 24 : 12;
+        double bytes = (verts.end-verts.start)*vert_bytes + (sites.end-sites.start)*16.0;
+        if (voro->gl_is_indexed()) {
+            bytes += (tris.end-tris.start)*12.0;
+        }
+        voro->gl_clear_dirty();
+        return bytes;
+    }
+    
+    template<typename F> void timed(const string &name, F fn) {
+        auto start = chrono::steady_clock::now();
+        fn();
+        auto end = chrono::steady_clock::now();
+        OpTimes &op = times(name);
+        op.us.push_back(chrono::duration<double, micro>(end-start).count());
+        op.upload_bytes += dirty_upload_bytes();
+    }
+    
+    bool run_line(const string &line, int lineno) {
+        istringstream in(line.substr(0, line.find('#')));
+        string op;
+        if (!(in >> op)) return true; // blank line
+        
+        if (op == "cells") {
+            int n = 0; double fill = .5;
+            in >> n >> fill;
+            timed("cells", [&]() {
+                delete voro;
+                voro = new Voro(glm::vec3(-10), glm::vec3(10));
+                for (int i=0; i<n; i++) {
+                    voro->add_cell(rand_pt(), randf(0, 1) < fill);
+                }
+            });
+            return true;
+        }
+        if (!voro) {
+            cerr << "line " << lineno << ": '" << op << "' needs a 'cells' op first" << endl;
+            return false;
+        }
+        if (op == "build_container") {
+            timed(op, [&]() { voro->build_container(); });
+        } else if (op == "reorder") {
+            timed("reorder_spatially", [&]() { voro->reorder_spatially(); });
+        } else if (op == "threads") {
+            int n = 0;
+            in >> n;
+            voro->set_build_threads(n);
+        } else if (op == "indexed") {
+            int on = 0;
+            in >> on;
+            voro->gl_set_indexed(on != 0);
+        } else if (op == "gl_build") {
+            int reps = 1;
+            in >> reps;
+            for (int r=0; r<reps; r++) {
+                timed(op, [&]() { voro->gl_build(32768, 1024, 10000); });
+            }
+        } else if (op == "palette") {
+            int n = 0;
+            in >> n;
+            vector<glm::vec3> pal;
+            for (int i=0; i<n; i++) {
+                pal.push_back(glm::vec3(randf(0, 1), randf(0, 1), randf(0, 1)));
+            }
+            timed("set_palette", [&]() { voro->set_palette(pal); });
+        } else if (op == "add") {
+            int n = 0;
+            in >> n;
+            for (int i=0; i<n; i++) {
+                glm::vec3 pt = rand_pt();
+                int type = randi(2);
+                timed("add_cell", [&]() { voro->add_cell(pt, type); voro->gl_flush(); });
+            }
+        } else if (op == "add_batch") {
+            int n = 0, k = 1000;
+            in >> n >> k;
+            for (int i=0; i<n; i++) {
+                vector<float> posns;
+                vector<int> types;
+                for (int j=0; j<k; j++) {
+                    glm::vec3 pt = rand_pt();
+                    posns.insert(posns.end(), {pt.x, pt.y, pt.z});
+                    types.push_back(randi(2));
+                }
+                timed("add_cells x"+to_string(k), [&]() { voro->add_cells(posns.data(), types.data(), k); voro->gl_flush(); });
+            }
+        } else if (op == "move") {
+            int n = 0, k = 1; float dist = .05f;
+            in >> n >> k >> dist;
+            for (int i=0; i<n && voro->cell_count() > 0; i++) {
+                unordered_set<int> picked;
+                vector<int> to_move;
+                vector<glm::vec3> posns;
+                int count = min(k, voro->cell_count());
+                while ((int)to_move.size() < count) {
+                    int c = randi(voro->cell_count());
+                    if (!picked.insert(c).second) continue;
+                    glm::vec3 pt = voro->cell_pos(c) + glm::vec3(randf(-dist, dist), randf(-dist, dist), randf(-dist, dist));
+                    pt = glm::clamp(pt, glm::vec3(-9.99f), glm::vec3(9.99f));
+                    to_move.push_back(c);
+                    posns.push_back(pt);
+                }
+                timed("move_cells x"+to_string(count), [&]() { voro->move_cells(to_move, posns); voro->gl_flush(); });
+            }
+        } else if (op == "move_each") {
+            int n = 0, k = 1; float dist = .05f;
+            in >> n >> k >> dist;
+            for (int i=0; i<n && voro->cell_count() > 0; i++) {
+                vector<int> to_move = pick_cluster(k);
+                vector<glm::vec3> posns;
+                for (int c : to_move) {
+                    glm::vec3 pt = voro->cell_pos(c) + glm::vec3(randf(-dist, dist), randf(-dist, dist), randf(-dist, dist));
+                    posns.push_back(glm::clamp(pt, glm::vec3(-9.99f), glm::vec3(9.99f)));
+                }
+                timed("move_cell x"+to_string(to_move.size()), [&]() {
+                    for (size_t j=0; j<to_move.size(); j++) {
+                        voro->move_cell(to_move[j], posns[j]);
+                    }
+                    voro->gl_flush();
+                });
+            }
+        } else if (op == "toggle") {
+            int n = 0, k = 1;
+            in >> n >> k;
+            for (int i=0; i<n && voro->cell_count() > 0; i++) {
+                vector<int> to_toggle = pick_cluster(k);
+                timed(k == 1 ? "toggle_cell" : "toggle_cell x"+to_string(to_toggle.size()), [&]() {
+                    for (int c : to_toggle) {
+                        voro->toggle_cell(c, 1);
+                    }
+                    voro->gl_flush();
+                });
+            }
+        } else if (op == "delete") {
+            int n = 0;
+            in >> n;
+            for (int i=0; i<n && voro->cell_count() > 0; i++) {
+                int c = randi(voro->cell_count());
+                timed("delete_cell", [&]() { voro->delete_cell(c); voro->gl_flush(); });
+            }
+        } else if (op == "export") {
+            int n = 0;
+            in >> n;
+            for (int i=0; i<n; i++) {
+                size_t faces = 0;
+                timed("export_index_mesh", [&]() { faces = voro->export_index_mesh().faces.size(); });
+                if (faces == 0) cerr << "warning: export produced no faces (call gl_build first?)" << endl;
+            }
+        } else {
+            cerr << "line " << lineno << ": unknown op '" << op << "'" << endl;
+            return false;
+        }
+        return true;
+    }
+    
+    static double percentile(const vector<double> &sorted, double p) {
+        if (sorted.empty()) return 0;
+        size_t i = size_t(p*(sorted.size()-1)+.5);
+        return sorted[min(i, sorted.size()-1)];
+    }
+    
+    void report() {
+        printf("%-20s %8s %12s %10s %10s %10s %10s %10s %12s\n", "op", "count", "total_ms", "mean_us", "p50_us", "p90_us", "p99_us", "max_us", "upload_kb");
+        for (auto &op : ops) {
+            vector<double> s = op.us;
+            sort(s.begin(), s.end());
+            double total = 0;
+            for (double t : s) total += t;
+            printf("%-20s %8d %12.3f %10.1f %10.1f %10.1f %10.1f %10.1f %12.1f\n", op.name.c_str(), (int)s.size(), total/1000.0,
+                   s.empty() ? 0 : total/s.size(), percentile(s, .5), percentile(s, .9), percentile(s, .99), s.empty() ? 0 : s.back(),
+                   s.empty() ? 0 : op.upload_bytes/1024/s.size());
+        }
+        if (voro) {
+            printf("final: %d cells, %d tris, %d verts\n", voro->cell_count(), voro->gl_tri_count(), voro->gl_vert_count());
+        }
+        printf("particle layout: %s\n", VOROPP_SOA_PARTICLES ? "soa" : "aos");
+    }
+};
+
+int main(int argc, char **argv) {
+    int num_cells = 10000;
+    unsigned seed = 1;
+    const char *script_file = 0;
+    for (int i=1; i<argc; i++) {
+        string arg = argv[i];
+        if (arg == "-n" && i+1 < argc) {
+            num_cells = atoi(argv[++i]);
+        } else if (arg == "-s" && i+1 < argc) {
+            seed = (unsigned)atoi(argv[++i]);
+        } else if (arg == "-h" || arg == "--help") {
+            cout << "usage: voro_bench [-n cells] [-s seed] [script_file | -]" << endl;
+            return 0;
+        } else {
+            script_file = argv[i];
+        }
+    }
+    
+    string script;
+    if (!script_file) {
+        script = default_script;
+        size_t at = script.find("$N");
+        script.replace(at, 2, to_string(num_cells));
+    } else if (string(script_file) == "-") {
+        script.assign(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+    } else {
+        ifstream f(script_file);
+        if (!f) {
+            cerr << "could not open script " << script_file << endl;
+            return 1;
+        }
+        script.assign(istreambuf_iterator<char>(f), istreambuf_iterator<char>());
+    }
+    
+    Bench bench(seed);
+    istringstream lines(script);
+    string line;
+    for (int lineno=1; getline(lines, line); lineno++) {
+        if (!bench.run_line(line, lineno)) return 1;
+    }
+    bench.report();
+    return 0;
+}
@@ -1,7 +1,7 @@
 // MIT Licensed code from ThreeJS with some changes by me (Jimmy) to
 // make this function a monkey patch of Mesh's raycast, in order to work around two issues:
 //
-// (1) raycast ignores geometry draw ranges, 
+// (1) raycast ignores geometry draw ranges (for both indexed and non-indexed geometry), 
 // (2) raycast bounding sphere check caches the bounding sphere and doesn't update when geometry changes 
 //         (... and in our case geometry never changes and we never even want the sphere check)
 // There's also a third issue where the raycast will get the wrong result for wireframe materials (draw ranges should be doubled in that case)
@@ -149,8 +149,9 @@ THREE.Mesh.prototype.raycast = ( function () {
             if ( index !== null ) {
 
                 // indexed buffer geometry
+                var l = Math.min(index.count,geometry.drawRange.start+geometry.drawRange.count);
 
-                for ( i = 0, l = index.count; i < l; i += 3 ) {
+                for ( i = geometry.drawRange.start; i < l; i += 3 ) {
 
                     a = index.getX( i );
                     b = index.getX( i + 1 );
@@ -161,6 +162,7 @@ THREE.Mesh.prototype.raycast = ( function () {
                     if ( intersection ) {
 
                         intersection.faceIndex = Math.floor( i / 3 ); // triangle number in indices buffer semantics
+                        intersection.index = i; // triangle number in positions buffer semantics, as if the geometry weren't indexed
                         intersects.push( intersection );
 
                     }
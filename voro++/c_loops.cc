@@ -110,14 +110,13 @@ void c_loop_subset::setup_box(double xmin,double xmax,double ymin,double ymax,do
  * current loop setup.
  * \return True if the point is out of bounds, false otherwise. */
 bool c_loop_subset::out_of_bounds() {
-	double *pp=p[ijk]+ps*q;
 	if(mode==sphere) {
-		double fx(*pp+px-v0),fy(pp[1]+py-v1),fz(pp[2]+pz-v2);
+		double fx(x()+px-v0),fy(y()+py-v1),fz(z()+pz-v2);
 		return fx*fx+fy*fy+fz*fz>v3;
 	} else {
-		double f(*pp+px);if(f<v0||f>v1) return true;
-		f=pp[1]+py;if(f<v2||f>v3) return true;
-		f=pp[2]+pz;return f<v4||f>v5;
+		double f(x()+px);if(f<v0||f>v1) return true;
+		f=y()+py;if(f<v2||f>v3) return true;
+		f=z()+pz;return f<v4||f>v5;
 	}
 }
 
@@ -11,6 +11,7 @@
 #define VOROPP_C_LOOPS_HH
 
 #include "config.hh"
+#include "particle_layout.hh"
 
 namespace voro {
 
@@ -102,6 +103,10 @@ class c_loop_base {
 		/** A pointer to the particle counts in the associated
 		 * container data structure. */
 		int *co;
+		/** A pointer to the particle memory sizes in the associated
+		 * container data structure, which set where each coordinate
+		 * lies under the particle_layout storage policy. */
+		int *mem;
 		/** The current x-index of the block under consideration by the
 		 * loop. */
 		int i;
@@ -123,13 +128,12 @@ class c_loop_base {
 		template<class c_class>
 		c_loop_base(c_class &con) : nx(con.nx), ny(con.ny), nz(con.nz),
 					    nxy(con.nxy), nxyz(con.nxyz), ps(con.ps),
-					    p(con.p), id(con.id), co(con.co) {}
+					    p(con.p), id(con.id), co(con.co), mem(con.mem) {}
 		/** Returns the position vector of the particle currently being
 		 * considered by the loop.
 		 * \param[out] (x,y,z) the position vector of the particle. */
 		inline void pos(double &x,double &y,double &z) {
-			double *pp=p[ijk]+ps*q;
-			x=*(pp++);y=*(pp++);z=*pp;
+			x=pc(0);y=pc(1);z=pc(2);
 		}
 		/** Returns the ID, position vector, and radius of the particle
 		 * currently being considered by the loop.
@@ -140,22 +144,26 @@ class c_loop_base {
 		 * 		 value is returned. */
 		inline void pos(int &pid,double &x,double &y,double &z,double &r) {
 			pid=id[ijk][q];
-			double *pp=p[ijk]+ps*q;
-			x=*(pp++);y=*(pp++);z=*pp;
-			r=ps==3?default_radius:*(++pp);
+			x=pc(0);y=pc(1);z=pc(2);
+			r=ps==3?default_radius:pc(3);
 		}
 		/** Returns the x position of the particle currently being
 		 * considered by the loop. */
-		inline double x() {return p[ijk][ps*q];}
+		inline double x() {return pc(0);}
 		/** Returns the y position of the particle currently being
 		 * considered by the loop. */
-		inline double y() {return p[ijk][ps*q+1];}
+		inline double y() {return pc(1);}
 		/** Returns the z position of the particle currently being
 		 * considered by the loop. */
-		inline double z() {return p[ijk][ps*q+2];}
+		inline double z() {return pc(2);}
 		/** Returns the ID of the particle currently being considered
 		 * by the loop. */
 		inline int pid() {return id[ijk][q];}
+	private:
+		/** Returns one coordinate of the particle currently being
+		 * considered by the loop.
+		 * \param[in] c the coordinate (0 to 3 for x, y, z and r). */
+		inline double pc(int c) {return p[ijk][particle_layout::at(ps,mem[ijk],q,c)];}
 };
 
 /** \brief Class for looping over all of the particles in a container.
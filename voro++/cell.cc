@@ -25,7 +25,8 @@ voronoicell_base::voronoicell_base() :
 	mec(new int[current_vertex_order]), mep(new int*[current_vertex_order]),
 	ds(new int[current_delete_size]), stacke(ds+current_delete_size),
 	ds2(new int[current_delete2_size]), stacke2(ds2+current_delete_size),
-	current_marginal(init_marginal), marg(new int[current_marginal]) {
+	current_marginal(init_marginal), marg(new int[current_marginal]),
+	fixed_lo(0), fixed_hi(0) {
 	int i;
 	for(i=0;i<3;i++) {
 		mem[i]=init_n_vertices;mec[i]=0;
@@ -39,14 +40,29 @@ voronoicell_base::voronoicell_base() :
 	}
 }
 
+/** Constructs a Voronoi cell whose arrays start out in caller-owned memory,
+ * such as the inline storage of the voronoicell_fixed classes. The arrays are
+ * replaced by heap arrays if they ever need to grow.
+ * \param[in] b the arrays to use, with the mem and mep entries already set up
+ *               for each vertex order. */
+voronoicell_base::voronoicell_base(const voronoicell_buffers &b) :
+	current_vertices(b.vertices), current_vertex_order(b.vertex_order),
+	current_delete_size(b.delete_size), current_delete2_size(b.delete_size),
+	ed(b.ed), nu(b.nu), pts(b.pts), mem(b.mem), mec(b.mec), mep(b.mep),
+	ds(b.ds), stacke(ds+current_delete_size),
+	ds2(b.ds2), stacke2(ds2+current_delete2_size),
+	current_marginal(b.marginal), marg(b.marg), fixed_lo(b.lo), fixed_hi(b.hi) {
+	for(int i=0;i<current_vertex_order;i++) mec[i]=0;
+}
+
 /** The voronoicell destructor deallocates all the dynamic memory. */
 voronoicell_base::~voronoicell_base() {
-	for(int i=current_vertex_order-1;i>=0;i--) if(mem[i]>0) delete [] mep[i];
-	delete [] marg;
-	delete [] ds2;delete [] ds;
-	delete [] mep;delete [] mec;
-	delete [] mem;delete [] pts;
-	delete [] nu;delete [] ed;
+	for(int i=current_vertex_order-1;i>=0;i--) if(mem[i]>0) release(mep[i]);
+	release(marg);
+	release(ds2);release(ds);
+	release(mep);release(mec);
+	release(mem);release(pts);
+	release(nu);release(ed);
 }
 
 /** Ensures that enough memory is allocated prior to carrying out a copy.
@@ -163,7 +179,7 @@ void voronoicell_base::add_memory(vc_class &vc,int i,int *stackp2) {
 			for(k=0;k<s;k++,j++) l[j]=mep[i][j];
 			for(k=0;k<i;k++,m++) vc.n_copy_to_aux1(i,m);
 		}
-		delete [] mep[i];
+		release(mep[i]);
 		mep[i]=l;
 		vc.n_switch_to_aux1(i);
 	}
@@ -184,14 +200,14 @@ void voronoicell_base::add_memory_vertices(vc_class &vc) {
 	double *ppts;
 	pp=new int*[i];
 	for(j=0;j<current_vertices;j++) pp[j]=ed[j];
-	delete [] ed;ed=pp;
+	release(ed);ed=pp;
 	vc.n_add_memory_vertices(i);
 	pnu=new int[i];
 	for(j=0;j<current_vertices;j++) pnu[j]=nu[j];
-	delete [] nu;nu=pnu;
+	release(nu);nu=pnu;
 	ppts=new double[3*i];
 	for(j=0;j<3*current_vertices;j++) ppts[j]=pts[j];
-	delete [] pts;pts=ppts;
+	release(pts);pts=ppts;
 	current_vertices=i;
 }
 
@@ -209,13 +225,13 @@ void voronoicell_base::add_memory_vorder(vc_class &vc) {
 #endif
 	p1=new int[i];
 	for(j=0;j<current_vertex_order;j++) p1[j]=mem[j];while(j<i) p1[j++]=0;
-	delete [] mem;mem=p1;
+	release(mem);mem=p1;
 	p2=new int*[i];
 	for(j=0;j<current_vertex_order;j++) p2[j]=mep[j];
-	delete [] mep;mep=p2;
+	release(mep);mep=p2;
 	p1=new int[i];
 	for(j=0;j<current_vertex_order;j++) p1[j]=mec[j];while(j<i) p1[j++]=0;
-	delete [] mec;mec=p1;
+	release(mec);mec=p1;
 	vc.n_add_memory_vorder(i);
 	current_vertex_order=i;
 }
@@ -231,7 +247,7 @@ void voronoicell_base::add_memory_ds(int *&stackp) {
 #endif
 	int *dsn=new int[current_delete_size],*dsnp=dsn,*dsp=ds;
 	while(dsp<stackp) *(dsnp++)=*(dsp++);
-	delete [] ds;ds=dsn;stackp=dsnp;
+	release(ds);ds=dsn;stackp=dsnp;
 	stacke=ds+current_delete_size;
 }
 
@@ -246,7 +262,7 @@ void voronoicell_base::add_memory_ds2(int *&stackp2) {
 #endif
 	int *dsn=new int[current_delete2_size],*dsnp=dsn,*dsp=ds2;
 	while(dsp<stackp2) *(dsnp++)=*(dsp++);
-	delete [] ds2;ds2=dsn;stackp2=dsnp;
+	release(ds2);ds2=dsn;stackp2=dsnp;
 	stacke2=ds2+current_delete2_size;
 }
 
@@ -1581,7 +1597,8 @@ inline void voronoicell_base::reset_edges() {
  * plane. If the point is far away from the test plane, the routine immediately
  * returns whether it is inside or outside. If the routine is close the the
  * plane and within the specified tolerance, then the special check_marginal()
- * routine is called.
+ * routine is called. If VOROPP_EXACT_PREDICATES is set, the tolerance is
+ * relative to the magnitudes of the terms in the scalar product.
  * \param[in] n the vertex to test.
  * \param[out] ans the result of the scalar product used in evaluating the
  *                 location of the point.
@@ -1592,21 +1609,70 @@ inline int voronoicell_base::m_test(int n,double &ans) {
 	ans=*(pp++)*px;
 	ans+=*(pp++)*py;
 	ans+=*pp*pz-prsq;
-	if(ans<-tolerance2) {
+#if VOROPP_EXACT_PREDICATES
+	pp-=2;
+	double tol2=relative_tolerance2*(fabs(*pp*px)+fabs(pp[1]*py)+fabs(pp[2]*pz)+prsq);
+#else
+	const double tol2=tolerance2;
+#endif
+	if(ans<-tol2) {
 		return -1;
-	} else if(ans>tolerance2) {
+	} else if(ans>tol2) {
 		return 1;
 	}
 	return check_marginal(n,ans);
 }
 
+#if VOROPP_EXACT_PREDICATES
+/** Adds a number to a floating point expansion without any rounding error,
+ * using Knuth's two-sum. The expansion is a sum of nonoverlapping terms held in
+ * order of increasing magnitude, and zero terms are left out.
+ * \param[in,out] e the terms of the expansion.
+ * \param[in] m the number of terms.
+ * \param[in] b the number to add.
+ * \return The new number of terms. */
+static inline int grow_expansion(double *e,int m,double b) {
+	int i,k=0;
+	double q=b,s,bv,av,err;
+	for(i=0;i<m;i++) {
+		s=q+e[i];bv=s-q;av=s-bv;
+		err=(q-av)+(e[i]-bv);
+		if(err!=0) e[k++]=err;
+		q=s;
+	}
+	if(q!=0) e[k++]=q;
+	return k;
+}
+
+/** Evaluates the scalar product used to locate a vertex relative to the test
+ * plane without rounding error, for vertices close to the plane. Each product
+ * is split into its rounded value and its rounding error using a fused
+ * multiply-add, and the seven parts are summed into an expansion, whose largest
+ * term has the sign of the exact result.
+ * \param[in] n the vertex to test.
+ * \return An approximation to the scalar product with the correct sign, which
+ *         is zero only if the product is exactly zero. */
+double voronoicell_base::exact_test(int n) {
+	double *pp=pts+3*n,e[7],h,ans;
+	int i,m=0;
+	h=*pp*px;m=grow_expansion(e,m,h);m=grow_expansion(e,m,fma(*pp,px,-h));
+	h=pp[1]*py;m=grow_expansion(e,m,h);m=grow_expansion(e,m,fma(pp[1],py,-h));
+	h=pp[2]*pz;m=grow_expansion(e,m,h);m=grow_expansion(e,m,fma(pp[2],pz,-h));
+	m=grow_expansion(e,m,-prsq);
+	if(m==0) return 0;
+	for(ans=*e,i=1;i<m;i++) ans+=e[i];
+	return ans;
+}
+#endif
+
 /** Checks to see if a given vertex is inside, outside or within the test
  * plane, for the case when the point has been detected to be very close to the
  * plane. The routine ensures that the returned results are always consistent
  * with previous tests, by keeping a table of any marginal results. The routine
  * first sees if the vertex is in the table, and if it finds a previously
  * computed result it uses that. Otherwise, it computes a result for this
- * vertex and adds it the table.
+ * vertex and adds it the table. If VOROPP_EXACT_PREDICATES is set, the
+ * result is computed from the exact value of the scalar product.
  * \param[in] n the vertex to test.
  * \param[in] ans the result of the scalar product used in evaluating
  *                the location of the point.
@@ -1624,11 +1690,17 @@ int voronoicell_base::check_marginal(int n,double &ans) {
 #endif
 		int *pmarg=new int[current_marginal];
 		for(int j=0;j<n_marg;j++) pmarg[j]=marg[j];
-		delete [] marg;
+		release(marg);
 		marg=pmarg;
 	}
 	marg[n_marg++]=n;
+#if VOROPP_EXACT_PREDICATES
+	double *pp=pts+3*n,tol=relative_tolerance*(fabs(*pp*px)+fabs(pp[1]*py)+fabs(pp[2]*pz)+prsq),
+	       ex=exact_test(n);
+	marg[n_marg++]=ex>tol?1:(ex<-tol?-1:0);
+#else
 	marg[n_marg++]=ans>tolerance?1:(ans<-tolerance?-1:0);
+#endif
 	return marg[n_marg-1];
 }
 
@@ -2021,78 +2093,84 @@ int voronoicell_base::number_of_edges() {
  * \param[in] r a radius associated with the particle.
  * \param[in] fp the file handle to write to. */
 void voronoicell_base::output_custom(const char *format,int i,double x,double y,double z,double r,FILE *fp) {
-	char *fmp=(const_cast<char*>(format));
-	std::vector<int> vi;
-	std::vector<double> vd;
-	while(*fmp!=0) {
-		if(*fmp=='%') {
-			fmp++;
-			switch(*fmp) {
-
-				// Particle-related output
-				case 'i': fprintf(fp,"%d",i);break;
-				case 'x': fprintf(fp,"%g",x);break;
-				case 'y': fprintf(fp,"%g",y);break;
-				case 'z': fprintf(fp,"%g",z);break;
-				case 'q': fprintf(fp,"%g %g %g",x,y,z);break;
-				case 'r': fprintf(fp,"%g",r);break;
-
-				// Vertex-related output
-				case 'w': fprintf(fp,"%d",p);break;
-				case 'p': output_vertices(fp);break;
-				case 'P': output_vertices(x,y,z,fp);break;
-				case 'o': output_vertex_orders(fp);break;
-				case 'm': fprintf(fp,"%g",0.25*max_radius_squared());break;
-
-				// Edge-related output
-				case 'g': fprintf(fp,"%d",number_of_edges());break;
-				case 'E': fprintf(fp,"%g",total_edge_distance());break;
-				case 'e': face_perimeters(vd);voro_print_vector(vd,fp);break;
-
-				// Face-related output
-				case 's': fprintf(fp,"%d",number_of_faces());break;
-				case 'F': fprintf(fp,"%g",surface_area());break;
-				case 'A': {
-						  face_freq_table(vi);
-						  voro_print_vector(vi,fp);
-					  } break;
-				case 'a': face_orders(vi);voro_print_vector(vi,fp);break;
-				case 'f': face_areas(vd);voro_print_vector(vd,fp);break;
-				case 't': {
-						  face_vertices(vi);
-						  voro_print_face_vertices(vi,fp);
-					  } break;
-				case 'l': normals(vd);
-					  voro_print_positions(vd,fp);
-					  break;
-				case 'n': neighbors(vi);
-					  voro_print_vector(vi,fp);
-					  break;
-
-				// Volume-related output
-				case 'v': fprintf(fp,"%g",volume());break;
-				case 'c': {
-						  double cx,cy,cz;
-						  centroid(cx,cy,cz);
-						  fprintf(fp,"%g %g %g",cx,cy,cz);
-					  } break;
-				case 'C': {
-						  double cx,cy,cz;
-						  centroid(cx,cy,cz);
-						  fprintf(fp,"%g %g %g",x+cx,y+cy,z+cz);
-					  } break;
-
-				// End-of-string reached
-				case 0: fmp--;break;
-
-				// The percent sign is not part of a
-				// control sequence
-				default: putc('%',fp);putc(*fmp,fp);
-			}
-		} else putc(*fmp,fp);
-		fmp++;
+	char buf[output_small_buffer_size];
+	custom_format cf(format);
+	output_buffer ob(fp,buf,output_small_buffer_size);
+	output_custom(cf,i,x,y,z,r,ob);
+}
+
+/** Outputs a custom string of information about the Voronoi cell to an
+ * output buffer, using a format string that has already been split into
+ * operations. When writing many cells, this avoids scanning the format string
+ * and calling the stdio routines for each one, so the container routines
+ * that print many cells use it, and the routine above writes through it
+ * too.
+ * \param[in] cf the custom format to use.
+ * \param[in] i the ID of the particle associated with this Voronoi cell.
+ * \param[in] (x,y,z) the position of the particle associated with this Voronoi
+ *                    cell.
+ * \param[in] r a radius associated with the particle.
+ * \param[in] ob the output buffer to write to. */
+void voronoicell_base::output_custom(const custom_format &cf,int i,double x,double y,double z,double r,output_buffer &ob) {
+	std::vector<int> &vi=ob.vi;
+	std::vector<double> &vd=ob.vd;
+	for(std::vector<custom_format::op>::const_iterator o=cf.ops.begin();o!=cf.ops.end();++o) {
+		switch(o->code) {
+
+			// Literal text
+			case 0: ob.put(cf.text.data()+o->start,o->len);break;
+
+			// Particle-related output
+			case 'i': ob.put_int(i);break;
+			case 'x': ob.put_double(x);break;
+			case 'y': ob.put_double(y);break;
+			case 'z': ob.put_double(z);break;
+			case 'q': ob.put_double(x);ob.put(' ');
+				  ob.put_double(y);ob.put(' ');
+				  ob.put_double(z);break;
+			case 'r': ob.put_double(r);break;
+
+			// Vertex-related output
+			case 'w': ob.put_int(p);break;
+			case 'p': vertices(vd);ob.put_positions(vd);break;
+			case 'P': vertices(x,y,z,vd);ob.put_positions(vd);break;
+			case 'o': vertex_orders(vi);ob.put_vector(vi);break;
+			case 'm': ob.put_double(0.25*max_radius_squared());break;
+
+			// Edge-related output
+			case 'g': ob.put_int(number_of_edges());break;
+			case 'E': ob.put_double(total_edge_distance());break;
+			case 'e': face_perimeters(vd);ob.put_vector(vd);break;
+
+			// Face-related output
+			case 's': ob.put_int(number_of_faces());break;
+			case 'F': ob.put_double(surface_area());break;
+			case 'A': face_freq_table(vi);ob.put_vector(vi);break;
+			case 'a': face_orders(vi);ob.put_vector(vi);break;
+			case 'f': face_areas(vd);ob.put_vector(vd);break;
+			case 't': face_vertices(vi);ob.put_face_vertices(vi);break;
+			case 'l': normals(vd);ob.put_positions(vd);break;
+			case 'n': neighbors(vi);ob.put_vector(vi);break;
+
+			// Volume-related output
+			case 'v': ob.put_double(volume());break;
+			case 'c': {
+					  double cx,cy,cz;
+					  centroid(cx,cy,cz);
+					  ob.put_double(cx);ob.put(' ');
+					  ob.put_double(cy);ob.put(' ');
+					  ob.put_double(cz);
+				  } break;
+			case 'C': {
+					  double cx,cy,cz;
+					  centroid(cx,cy,cz);
+					  ob.put_double(x+cx);ob.put(' ');
+					  ob.put_double(y+cy);ob.put(' ');
+					  ob.put_double(z+cz);
+				  }
+		}
 	}
-	fputs("\n",fp);
+	ob.put('\n');
 }
 
 /** This initializes the class to be a rectangular box. It calls the base class
@@ -2189,9 +2267,9 @@ voronoicell_neighbor::voronoicell_neighbor() {
 /** The class destructor frees the dynamically allocated memory for storing
  * neighbor information. */
 voronoicell_neighbor::~voronoicell_neighbor() {
-	for(int i=current_vertex_order-1;i>=0;i--) if(mem[i]>0) delete [] mne[i];
-	delete [] mne;
-	delete [] ne;
+	for(int i=current_vertex_order-1;i>=0;i--) if(mem[i]>0) release(mne[i]);
+	release(mne);
+	release(ne);
 }
 
 /** Computes a vector list of neighbors. */
@@ -2215,6 +2293,58 @@ void voronoicell_neighbor::neighbors(std::vector<int> &v) {
 	reset_edges();
 }
 
+/** Computes the faces, the neighbor of each face, and the vertices of the
+ * cell in a single walk over the edges, writing them into arrays supplied by
+ * the caller. The faces and neighbors come out in the same order as from the
+ * face_vertices() and neighbors() routines, but the vertices are renumbered in
+ * the order that the faces first reference them, so that only the vertices
+ * that are used are stored. The arrays should be sized using face_mesh_size().
+ * \param[in] (x,y,z) the position vector of the particle in the global
+ *                    coordinate system.
+ * \param[out] fv the array to store the faces in, as the number of vertices
+ *                in the first face, followed by its vertex indices, then the
+ *                number of vertices in the second face, and so on.
+ * \param[out] fn the array to store the neighbor of each face in.
+ * \param[out] v the array to store the vertex vectors in, in the global
+ *               coordinate system.
+ * \param[in] vmap scratch space for mapping vertices to their new indices.
+ * \param[out] fv_len the number of entries written to fv.
+ * \param[out] nf the number of faces.
+ * \param[out] nv the number of vertices. */
+void voronoicell_neighbor::face_mesh(double x,double y,double z,int *fv,int *fn,double *v,int *vmap,int &fv_len,int &nf,int &nv) {
+	int i,j,k,l,m,*fp=fv,*fs;
+	for(i=0;i<p;i++) vmap[i]=-1;
+	nf=nv=0;
+	for(i=1;i<p;i++) for(j=0;j<nu[i];j++) {
+		k=ed[i][j];
+		if(k>=0) {
+			fn[nf++]=ne[i][j];
+			fs=fp++;
+			ed[i][j]=-1-k;
+			l=cycle_up(ed[i][nu[i]+j],k);
+			m=i;
+			do {
+				if(vmap[m]<0) {
+					vmap[m]=nv;
+					v[3*nv]=x+pts[3*m]*0.5;
+					v[3*nv+1]=y+pts[3*m+1]*0.5;
+					v[3*nv+2]=z+pts[3*m+2]*0.5;
+					nv++;
+				}
+				*(fp++)=vmap[m];
+				m=k;
+				if(k==i) break;
+				k=ed[m][l];
+				ed[m][l]=-1-k;
+				l=cycle_up(ed[m][nu[m]+l],k);
+			} while(true);
+			*fs=int(fp-fs)-1;
+		}
+	}
+	fv_len=int(fp-fv);
+	reset_edges();
+}
+
 /** Prints the vertices, their edges, the relation table, and also notifies if
  * any memory errors are visible. */
 void voronoicell_base::print_edges() {
@@ -14,9 +14,33 @@
 
 #include "config.hh"
 #include "common.hh"
+#include "output_buffer.hh"
 
 namespace voro {
 
+/** \brief A set of caller-owned arrays for a Voronoi cell to start out with.
+ *
+ * The voronoicell_fixed and voronoicell_neighbor_fixed classes use this to
+ * hand their inline storage to voronoicell_base. Arrays that lie within
+ * [lo,hi) are never freed; when one of them runs out of space, it is replaced
+ * by a heap array in the usual way. */
+struct voronoicell_buffers {
+	/** The sizes of the vertex arrays, the vertex order arrays, the
+	 * two delete stacks and the marginal buffer. */
+	int vertices,vertex_order,delete_size,marginal;
+	/** The initial ed, nu, and pts arrays. */
+	int **ed,*nu;double *pts;
+	/** The initial mem, mec, and mep arrays, with mem and mep already
+	 * set up for each vertex order. */
+	int *mem,*mec,**mep;
+	/** The initial delete stacks and marginal buffer. */
+	int *ds,*ds2,*marg;
+	/** The initial ne and mne arrays, for neighbor tracking. */
+	int **ne,**mne;
+	/** The bounds of the memory holding all of the arrays above. */
+	char *lo,*hi;
+};
+
 /** \brief A class representing a single Voronoi cell.
  *
  * This class represents a single Voronoi cell, as a collection of vertices
@@ -84,6 +108,7 @@ class voronoicell_base {
 		 * the positions of the vertices. */
 		double *pts;
 		voronoicell_base();
+		voronoicell_base(const voronoicell_buffers &b);
 		~voronoicell_base();
 		void init_base(double xmin,double xmax,double ymin,double ymax,double zmin,double zmax);
 		void init_octahedron_base(double l);
@@ -181,6 +206,7 @@ class voronoicell_base {
 		 * \param[in] fp the file handle to write to. */
 		inline void output_custom(const char *format,FILE *fp=stdout) {output_custom(format,0,0,0,0,default_radius,fp);}
 		void output_custom(const char *format,int i,double x,double y,double z,double r,FILE *fp=stdout);
+		void output_custom(const custom_format &cf,int i,double x,double y,double z,double r,output_buffer &ob);
 		template<class vc_class>
 		bool nplane(vc_class &vc,double x,double y,double z,double rsq,int p_id);
 		bool plane_intersects(double x,double y,double z,double rsq);
@@ -256,6 +282,15 @@ class voronoicell_base {
 		/** This array contains a list of the marginal points, and also
 		 * the outcomes of the marginal tests. */
 		int *marg;
+		/** The bounds of any inline storage that the arrays started
+		 * out in, which must not be freed. */
+		char *fixed_lo,*fixed_hi;
+		/** Frees an array, unless it is part of the inline storage.
+		 * \param[in] a the array to free. */
+		template<class T>
+		inline void release(T *a) {
+			if((char*) a<fixed_lo||(char*) a>=fixed_hi) delete [] a;
+		}
 		/** The x coordinate of the normal vector to the test plane. */
 		double px;
 		/** The y coordinate of the normal vector to the test plane. */
@@ -287,6 +322,9 @@ class voronoicell_base {
 		inline bool search_edge(int l,int &m,int &k);
 		inline int m_test(int n,double &ans);
 		int check_marginal(int n,double &ans);
+#if VOROPP_EXACT_PREDICATES
+		double exact_test(int n);
+#endif
 		friend class voronoicell;
 		friend class voronoicell_neighbor;
 };
@@ -300,6 +338,11 @@ class voronoicell_base {
 class voronoicell : public voronoicell_base {
 	public:
 		using voronoicell_base::nplane;
+		voronoicell() {}
+		/** Constructs a Voronoi cell that starts out in the given
+		 * arrays.
+		 * \param[in] b the arrays to use. */
+		voronoicell(const voronoicell_buffers &b) : voronoicell_base(b) {}
 		/** Copies the information from another voronoicell class into
 		 * this class, extending memory allocation if necessary.
 		 * \param[in] c the class to copy. */
@@ -416,6 +459,10 @@ class voronoicell_neighbor : public voronoicell_base {
 		 * face that is clockwise from the jth edge. */
 		int **ne;
 		voronoicell_neighbor();
+		/** Constructs a Voronoi cell that starts out in the given
+		 * arrays.
+		 * \param[in] b the arrays to use. */
+		voronoicell_neighbor(const voronoicell_buffers &b) : voronoicell_base(b), mne(b.mne), ne(b.ne) {}
 		~voronoicell_neighbor();
 		void operator=(voronoicell &c);
 		void operator=(voronoicell_neighbor &c);
@@ -468,6 +515,20 @@ class voronoicell_neighbor : public voronoicell_base {
 		void init_tetrahedron(double x0,double y0,double z0,double x1,double y1,double z1,double x2,double y2,double z2,double x3,double y3,double z3);
 		void check_facets();
 		virtual void neighbors(std::vector<int> &v);
+		/** Computes upper bounds on the amount of memory needed by the
+		 * face_mesh() routine.
+		 * \param[out] fv_size the number of entries needed in the face
+		 *                     vertex array.
+		 * \param[out] f_size the number of faces, which is also the
+		 *                    number of entries needed in the neighbor
+		 *                    array. The vertex array needs 3*p entries,
+		 *                    and the scratch array p entries. */
+		inline void face_mesh_size(int &fv_size,int &f_size) {
+			int s=0;
+			for(int i=0;i<p;i++) s+=nu[i];
+			f_size=s/3;fv_size=s+f_size;
+		}
+		void face_mesh(double x,double y,double z,int *fv,int *fn,double *v,int *vmap,int &fv_len,int &nf,int &nv);
 		virtual void print_edges_neighbors(int i);
 		virtual void output_neighbors(FILE *fp=stdout) {
 			std::vector<int> v;neighbors(v);
@@ -480,12 +541,12 @@ class voronoicell_neighbor : public voronoicell_base {
 		inline void n_add_memory_vertices(int i) {
 			int **pp=new int*[i];
 			for(int j=0;j<current_vertices;j++) pp[j]=ne[j];
-			delete [] ne;ne=pp;
+			release(ne);ne=pp;
 		}
 		inline void n_add_memory_vorder(int i) {
 			int **p2=new int*[i];
 			for(int j=0;j<current_vertex_order;j++) p2[j]=mne[j];
-			delete [] mne;mne=p2;
+			release(mne);mne=p2;
 		}
 		inline void n_set_pointer(int p,int n) {
 			ne[p]=mne[n]+n*mec[n];
@@ -503,12 +564,113 @@ class voronoicell_neighbor : public voronoicell_base {
 		inline void n_set_to_aux1(int j) {ne[j]=paux1;}
 		inline void n_set_to_aux2(int j) {ne[j]=paux2;}
 		inline void n_allocate_aux1(int i) {paux1=new int[i*mem[i]];}
-		inline void n_switch_to_aux1(int i) {delete [] mne[i];mne[i]=paux1;}
+		inline void n_switch_to_aux1(int i) {release(mne[i]);mne[i]=paux1;}
 		inline void n_copy_to_aux1(int i,int m) {paux1[m]=mne[i][m];}
 		inline void n_set_to_aux1_offset(int k,int m) {ne[k]=paux1+m;}
 		friend class voronoicell_base;
 };
 
+/** \brief Inline storage for the arrays of a Voronoi cell with up to nv
+ * vertices.
+ *
+ * The order 3 vertex memory holds nv vertices, and each other vertex order up
+ * to fixed_vertex_order holds init_n_vertices vertices. Since the cell
+ * initialization routines don't check for space, nv must be at least eight. */
+template<int nv>
+struct voronoicell_storage {
+	/** A compile-time check that nv is at least eight, since the
+	 * initial box cell has eight vertices. */
+	typedef char nv_check[nv>=8?1:-1];
+	int *s_ed[nv];
+	int s_nu[nv];
+	double s_pts[3*nv];
+	int s_mem[fixed_vertex_order],s_mec[fixed_vertex_order];
+	int *s_mep[fixed_vertex_order];
+	int s_mepb[7*nv+init_n_vertices*(fixed_vertex_order*fixed_vertex_order-7)];
+	int s_ds[nv],s_ds2[nv];
+	int s_marg[init_marginal];
+	/** Sets up the memory for each vertex order, and returns a
+	 * description of the arrays for the voronoicell_base constructor. */
+	voronoicell_buffers buffers() {
+		voronoicell_buffers b;
+		b.vertices=nv;b.vertex_order=fixed_vertex_order;
+		b.delete_size=nv;b.marginal=init_marginal;
+		b.ed=s_ed;b.nu=s_nu;b.pts=s_pts;
+		b.mem=s_mem;b.mec=s_mec;b.mep=s_mep;
+		b.ds=s_ds;b.ds2=s_ds2;b.marg=s_marg;
+		int *q=s_mepb;
+		for(int i=0;i<fixed_vertex_order;i++) {
+			s_mem[i]=i==3?nv:init_n_vertices;
+			s_mep[i]=q;q+=s_mem[i]*((i<<1)+1);
+		}
+		b.ne=b.mne=0;
+		b.lo=(char*) this;b.hi=(char*) (this+1);
+		return b;
+	}
+};
+
+/** \brief Inline storage for the arrays of a Voronoi cell with up to nv
+ * vertices, including the neighbor information. */
+template<int nv>
+struct voronoicell_neighbor_storage : public voronoicell_storage<nv> {
+	int *s_ne[nv];
+	int *s_mne[fixed_vertex_order];
+	int s_mneb[3*nv+init_n_vertices*(fixed_vertex_order*(fixed_vertex_order-1)/2-3)];
+	/** Sets up the memory for each vertex order, and returns a
+	 * description of the arrays for the voronoicell_neighbor
+	 * constructor. */
+	voronoicell_buffers buffers() {
+		voronoicell_buffers b(voronoicell_storage<nv>::buffers());
+		int *q=s_mneb;
+		for(int i=0;i<fixed_vertex_order;i++) {
+			s_mne[i]=q;q+=this->s_mem[i]*i;
+		}
+		b.ne=s_ne;b.mne=s_mne;
+		b.lo=(char*) this;b.hi=(char*) (this+1);
+		return b;
+	}
+};
+
+/** \brief A voronoicell that keeps its arrays in inline storage.
+ *
+ * This class behaves exactly like voronoicell, but its arrays start out
+ * inside the object, with room for nv vertices, rather than being allocated
+ * on the heap. Constructing one of these for a typical cell therefore doesn't
+ * allocate any memory, which makes it cheap to create temporary cells for
+ * each thread or task. If a cell outgrows the inline storage, the arrays that
+ * run out of space are moved to the heap as usual. Since the arrays live
+ * inside the object, it can't be copy constructed, but it can be assigned
+ * from another cell. */
+template<int nv=64>
+class voronoicell_fixed : private voronoicell_storage<nv>, public voronoicell {
+	public:
+		voronoicell_fixed() : voronoicell(voronoicell_storage<nv>::buffers()) {}
+		/** Copies the information from another voronoicell class into
+		 * this class, extending memory allocation if necessary.
+		 * \param[in] c the class to copy. */
+		inline void operator=(voronoicell &c) {voronoicell::operator=(c);}
+		inline void operator=(voronoicell_fixed<nv> &c) {voronoicell::operator=(c);}
+	private:
+		voronoicell_fixed(const voronoicell_fixed<nv> &c);
+};
+
+/** \brief A voronoicell_neighbor that keeps its arrays in inline storage.
+ *
+ * This is the neighbor tracking version of voronoicell_fixed. */
+template<int nv=64>
+class voronoicell_neighbor_fixed : private voronoicell_neighbor_storage<nv>, public voronoicell_neighbor {
+	public:
+		voronoicell_neighbor_fixed() : voronoicell_neighbor(voronoicell_neighbor_storage<nv>::buffers()) {}
+		/** Copies the information from another Voronoi cell class into
+		 * this class, extending memory allocation if necessary.
+		 * \param[in] c the class to copy. */
+		inline void operator=(voronoicell &c) {voronoicell_neighbor::operator=(c);}
+		inline void operator=(voronoicell_neighbor &c) {voronoicell_neighbor::operator=(c);}
+		inline void operator=(voronoicell_neighbor_fixed<nv> &c) {voronoicell_neighbor::operator=(c);}
+	private:
+		voronoicell_neighbor_fixed(const voronoicell_neighbor_fixed<nv> &c);
+};
+
 }
 
 #endif
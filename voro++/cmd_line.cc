@@ -29,8 +29,14 @@ void help_message() {
 	     "               <y_max> <z_min> <z_max> <filename>\n\n"
 	     "By default, the utility reads in the input file of particle IDs and positions,\n"
 	     "computes the Voronoi cell for each, and then creates <filename.vol> with an\n"
-	     "additional column containing the volume of each Voronoi cell.\n\n"
+	     "additional column containing the volume of each Voronoi cell. The input file\n"
+	     "may also be in the binary particle format described in particle_reader.hh,\n"
+	     "which is detected automatically.\n\n"
 	     "Available options:\n"
+	     " -b         : Write the quantities in the custom output string as binary\n"
+	     "              columns to <filename.vbin>, instead of <filename.vol>; see\n"
+	     "              column_output.hh for the format\n"
+	     " -bd        : Like -b, but store floating point numbers in double precision\n"
 	     " -c <str>   : Specify a custom output string\n"
 	     " -g         : Turn on the gnuplot output to <filename.gnu>\n"
 	     " -h/--help  : Print this information\n"
@@ -123,13 +129,16 @@ void error_message() {
 // Carries out the Voronoi computation and outputs the results to the requested
 // files
 template<class c_loop,class c_class>
-void cmd_line_output(c_loop &vl,c_class &con,const char* format,FILE* outfile,FILE* gnu_file,FILE* povp_file,FILE* povv_file,bool verbose,double &vol,int &vcc,int &tp) {
+void cmd_line_output(c_loop &vl,c_class &con,const char* format,FILE* outfile,column_output* col_out,FILE* gnu_file,FILE* povp_file,FILE* povv_file,bool verbose,double &vol,int &vcc,int &tp) {
 	int pid,ps=con.ps;double x,y,z,r;
+	custom_format cf(format);
+	output_buffer ob(outfile);
 	if(con.contains_neighbor(format)) {
 		voronoicell_neighbor c;
 		if(vl.start()) do if(con.compute_cell(c,vl)) {
 			vl.pos(pid,x,y,z,r);
-			if(outfile!=NULL) c.output_custom(format,pid,x,y,z,r,outfile);
+			if(outfile!=NULL) c.output_custom(cf,pid,x,y,z,r,ob);
+			if(col_out!=NULL) col_out->add_cell(c,pid,x,y,z,r);
 			if(gnu_file!=NULL) c.draw_gnuplot(x,y,z,gnu_file);
 			if(povp_file!=NULL) {
 				fprintf(povp_file,"// id %d\n",pid);
@@ -146,7 +155,8 @@ void cmd_line_output(c_loop &vl,c_class &con,const char* format,FILE* outfile,FI
 		voronoicell c;
 		if(vl.start()) do if(con.compute_cell(c,vl)) {
 			vl.pos(pid,x,y,z,r);
-			if(outfile!=NULL) c.output_custom(format,pid,x,y,z,r,outfile);
+			if(outfile!=NULL) c.output_custom(cf,pid,x,y,z,r,ob);
+			if(col_out!=NULL) col_out->add_cell(c,pid,x,y,z,r);
 			if(gnu_file!=NULL) c.draw_gnuplot(x,y,z,gnu_file);
 			if(povp_file!=NULL) {
 				fprintf(povp_file,"// id %d\n",pid);
@@ -169,6 +179,7 @@ int main(int argc,char **argv) {
 	blocks_mode bm=none;
 	bool gnuplot_output=false,povp_output=false,povv_output=false,polydisperse=false;
 	bool xperiodic=false,yperiodic=false,zperiodic=false,ordered=false,verbose=false;
+	bool binary_output=false,double_output=false;
 	pre_container *pcon=NULL;pre_container_poly *pconp=NULL;
 	wall_list wl;
 
@@ -197,7 +208,11 @@ int main(int argc,char **argv) {
 	// We have enough arguments. Now start searching for command-line
 	// options.
 	while(i<argc-7) {
-		if(strcmp(argv[i],"-c")==0) {
+		if(strcmp(argv[i],"-b")==0) {
+			binary_output=true;
+		} else if(strcmp(argv[i],"-bd")==0) {
+			binary_output=double_output=true;
+		} else if(strcmp(argv[i],"-c")==0) {
 			if(i>=argc-8) {error_message();wl.deallocate();return VOROPP_CMD_LINE_ERROR;}
 			if(custom_output==0) {
 				custom_output=++i;
@@ -407,8 +422,14 @@ int main(int argc,char **argv) {
 
 	// Open files for output
 	char *buffer=new char[flen+7];
-	sprintf(buffer,"%s.vol",argv[i+6]);
-	FILE *outfile=safe_fopen(buffer,"w"),*gnu_file,*povp_file,*povv_file;
+	FILE *outfile=NULL,*bin_file=NULL,*gnu_file,*povp_file,*povv_file;
+	if(binary_output) {
+		sprintf(buffer,"%s.vbin",argv[i+6]);
+		bin_file=safe_fopen(buffer,"wb");
+	} else {
+		sprintf(buffer,"%s.vol",argv[i+6]);
+		outfile=safe_fopen(buffer,"w");
+	}
 	if(gnuplot_output) {
 		sprintf(buffer,"%s.gnu",argv[i+6]);
 		gnu_file=safe_fopen(buffer,"w");
@@ -424,6 +445,7 @@ int main(int argc,char **argv) {
 	delete [] buffer;
 
 	const char *c_str=(custom_output==0?(polydisperse?"%i %q %v %r":"%i %q %v"):argv[custom_output]);
+	column_output *col_out=binary_output?new column_output(c_str,double_output):NULL;
 
 	// Now switch depending on whether polydispersity was enabled, and
 	// whether output ordering is requested
@@ -438,7 +460,7 @@ int main(int argc,char **argv) {
 			} else con.import(vo,argv[i+6]);
 
 			c_loop_order vlo(con,vo);
-			cmd_line_output(vlo,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			cmd_line_output(vlo,con,c_str,outfile,col_out,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
 		} else {
 			container_poly con(ax,bx,ay,by,az,bz,nx,ny,nz,xperiodic,yperiodic,zperiodic,init_mem);
 			con.add_wall(wl);
@@ -448,7 +470,7 @@ int main(int argc,char **argv) {
 			} else con.import(argv[i+6]);
 
 			c_loop_all vla(con);
-			cmd_line_output(vla,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			cmd_line_output(vla,con,c_str,outfile,col_out,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
 		}
 	} else {
 		if(ordered) {
@@ -460,7 +482,7 @@ int main(int argc,char **argv) {
 			} else con.import(vo,argv[i+6]);
 
 			c_loop_order vlo(con,vo);
-			cmd_line_output(vlo,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			cmd_line_output(vlo,con,c_str,outfile,col_out,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
 		} else {
 			container con(ax,bx,ay,by,az,bz,nx,ny,nz,xperiodic,yperiodic,zperiodic,init_mem);
 			con.add_wall(wl);
@@ -468,7 +490,7 @@ int main(int argc,char **argv) {
 				pcon->setup(con);delete pcon;
 			} else con.import(argv[i+6]);
 			c_loop_all vla(con);
-			cmd_line_output(vla,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			cmd_line_output(vla,con,c_str,outfile,col_out,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
 		}
 	}
 
@@ -489,7 +511,11 @@ int main(int argc,char **argv) {
 	}
 			   
 	// Close output files
-	fclose(outfile);
+	if(binary_output) {
+		col_out->write(bin_file);
+		delete col_out;
+		fclose(bin_file);
+	} else fclose(outfile);
 	if(gnu_file!=NULL) fclose(gnu_file);
 	if(povp_file!=NULL) fclose(povp_file);
 	if(povv_file!=NULL) fclose(povv_file);
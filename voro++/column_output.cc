@@ -0,0 +1,219 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file column_output.cc
+ * \brief Function implementations for the column_output class. */
+
+#include <cmath>
+#include <cstring>
+
+#include "column_output.hh"
+
+namespace voro {
+
+/** The class constructor sets up a column for each distinct control character
+ * in a custom output string, each with temporary files to hold its values
+ * until they are written out.
+ * \param[in] format the custom output string.
+ * \param[in] double_precision whether to store floating point numbers as
+ *                             doubles, instead of single precision floats. */
+column_output::column_output(const char *format,bool double_precision) : ncells(0) {
+	const char ft=double_precision?'d':'f';
+	const int one=1;
+	swap=*reinterpret_cast<const char*>(&one)==0;
+	custom_format cf(format);
+	for(std::vector<custom_format::op>::iterator o=cf.ops.begin();o!=cf.ops.end();++o) {
+		if(o->code==0) continue;
+		bool dup=false;
+		for(std::vector<column>::iterator c=cols.begin();c!=cols.end();++c) if(c->code==o->code) dup=true;
+		if(dup) continue;
+		column co;
+		co.code=o->code;co.count=0;
+		switch(o->code) {
+			case 'i': case 'w': case 'g': case 's': co.type='i';co.width=1;break;
+			case 'q': case 'c': case 'C': co.type=ft;co.width=3;break;
+			case 'o': case 'A': case 'a': case 't': case 'n': co.type='i';co.width=0;break;
+			case 'p': case 'P': case 'e': case 'f': case 'l': co.type=ft;co.width=0;break;
+			default: co.type=ft;co.width=1;
+		}
+		co.vf=tmpfile();
+		co.of=co.width==0?tmpfile():NULL;
+		if(co.vf==NULL||(co.width==0&&co.of==NULL))
+			voro_fatal_error("Unable to open temporary file for column output",VOROPP_FILE_ERROR);
+		co.vb=new output_buffer(co.vf);
+		co.ob=co.width==0?new output_buffer(co.of):NULL;
+		if(co.width==0) put_int64(co.ob,0);
+		cols.push_back(co);
+	}
+}
+
+/** The class destructor frees the buffers and closes the temporary files. */
+column_output::~column_output() {
+	for(std::vector<column>::iterator c=cols.begin();c!=cols.end();++c) {
+		delete c->vb;fclose(c->vf);
+		if(c->width==0) {delete c->ob;fclose(c->of);}
+	}
+}
+
+/** Adds integers to a column.
+ * \param[in] co the column.
+ * \param[in] v a pointer to the integers.
+ * \param[in] n the number of integers. */
+void column_output::put(column &co,const int *v,int n) {
+	if(n==0) return;
+	if(swap) for(int k=0;k<n;k++) {
+		unsigned int u=v[k];
+		u=(u>>24)|((u>>8)&0xff00)|((u<<8)&0xff0000)|(u<<24);
+		co.vb->put(reinterpret_cast<const char*>(&u),4);
+	} else co.vb->put(reinterpret_cast<const char*>(v),4*size_t(n));
+	co.count+=n;
+}
+
+/** Adds floating point numbers to a column, converting them to single
+ * precision if the column holds floats.
+ * \param[in] co the column.
+ * \param[in] v a pointer to the numbers.
+ * \param[in] n the number of numbers. */
+void column_output::put(column &co,const double *v,int n) {
+	if(n==0) return;
+	if(co.type=='f') {
+		for(int k=0;k<n;k++) {
+			float f=float(v[k]);
+			unsigned int u;
+			memcpy(&u,&f,4);
+			if(swap) u=(u>>24)|((u>>8)&0xff00)|((u<<8)&0xff0000)|(u<<24);
+			co.vb->put(reinterpret_cast<const char*>(&u),4);
+		}
+	} else if(swap) for(int k=0;k<n;k++) {
+		char b[8];
+		memcpy(b,v+k,8);
+		for(int j=7;j>=0;j--) co.vb->put(b[j]);
+	} else co.vb->put(reinterpret_cast<const char*>(v),8*size_t(n));
+	co.count+=n;
+}
+
+/** Adds a little-endian 32-bit integer to a buffer.
+ * \param[in] b the buffer.
+ * \param[in] v the integer. */
+void column_output::put_int32(output_buffer *b,unsigned int v) {
+	unsigned int u=v;
+	for(int j=0;j<4;j++,u>>=8) b->put(char(u&0xff));
+}
+
+/** Adds a little-endian 64-bit integer to a buffer, as two 32-bit halves.
+ * \param[in] b the buffer.
+ * \param[in] v the integer, which must be non-negative. */
+void column_output::put_int64(output_buffer *b,double v) {
+	double h=floor(v/4294967296.0);
+	put_int32(b,static_cast<unsigned int>(v-4294967296.0*h));
+	put_int32(b,static_cast<unsigned int>(h));
+}
+
+/** Adds the statistics of a Voronoi cell to the columns.
+ * \param[in] c the Voronoi cell.
+ * \param[in] i the ID of the particle associated with the cell.
+ * \param[in] (x,y,z) the position of the particle.
+ * \param[in] r a radius associated with the particle. */
+void column_output::add_cell(voronoicell_base &c,int i,double x,double y,double z,double r) {
+	for(std::vector<column>::iterator co=cols.begin();co!=cols.end();++co) {
+		switch(co->code) {
+
+			// Particle-related output
+			case 'i': put(*co,i);break;
+			case 'x': put(*co,x);break;
+			case 'y': put(*co,y);break;
+			case 'z': put(*co,z);break;
+			case 'q': {double q[3]={x,y,z};put(*co,q,3);} break;
+			case 'r': put(*co,r);break;
+
+			// Vertex-related output
+			case 'w': put(*co,c.p);break;
+			case 'p': c.vertices(vd);put(*co,vd);break;
+			case 'P': c.vertices(x,y,z,vd);put(*co,vd);break;
+			case 'o': c.vertex_orders(vi);put(*co,vi);break;
+			case 'm': put(*co,0.25*c.max_radius_squared());break;
+
+			// Edge-related output
+			case 'g': put(*co,c.number_of_edges());break;
+			case 'E': put(*co,c.total_edge_distance());break;
+			case 'e': c.face_perimeters(vd);put(*co,vd);break;
+
+			// Face-related output
+			case 's': put(*co,c.number_of_faces());break;
+			case 'F': put(*co,c.surface_area());break;
+			case 'A': c.face_freq_table(vi);put(*co,vi);break;
+			case 'a': c.face_orders(vi);put(*co,vi);break;
+			case 'f': c.face_areas(vd);put(*co,vd);break;
+			case 't': c.face_vertices(vi);put(*co,vi);break;
+			case 'l': c.normals(vd);put(*co,vd);break;
+			case 'n': c.neighbors(vi);put(*co,vi);break;
+
+			// Volume-related output
+			case 'v': put(*co,c.volume());break;
+			case 'c': case 'C': {
+					  double q[3];
+					  c.centroid(q[0],q[1],q[2]);
+					  if(co->code=='C') {q[0]+=x;q[1]+=y;q[2]+=z;}
+					  put(*co,q,3);
+				  }
+		}
+		if(co->width==0) put_int64(co->ob,co->count);
+	}
+	ncells++;
+}
+
+/** Copies the contents of a temporary file to the output file, followed by
+ * zeros to pad it to a multiple of eight bytes.
+ * \param[in] src the temporary file.
+ * \param[in] fp the file handle to write to.
+ * \param[in,out] pos the position in the output file. */
+void column_output::copy(FILE *src,FILE *fp,double &pos) {
+	char buf[65536];size_t l;
+	rewind(src);
+	while((l=fread(buf,1,sizeof(buf),src))>0) {
+		fwrite(buf,1,l,fp);
+		pos+=l;
+	}
+	while(fmod(pos,8)!=0) {putc(0,fp);pos++;}
+}
+
+/** Writes the header and all of the columns to a file.
+ * \param[in] fp the file handle to write to. */
+void column_output::write(FILE *fp) {
+	output_buffer hb(fp);
+	const int ncols=cols.size();
+	double pos=24+32*ncols,vo,oo;
+
+	// Write the header and the column entries, working out where each
+	// array will be placed
+	hb.put(column_file_magic,8);
+	put_int32(&hb,1);
+	put_int32(&hb,ncols);
+	put_int64(&hb,ncells);
+	for(std::vector<column>::iterator co=cols.begin();co!=cols.end();++co) {
+		co->vb->flush();
+		if(co->width==0) co->ob->flush();
+		vo=pos;
+		pos+=(co->type=='d'?8:4)*co->count;
+		pos=8*ceil(pos/8);
+		if(co->width==0) {oo=pos;pos+=8*(ncells+1);} else oo=0;
+		hb.put(co->code);hb.put(co->type);hb.put(0);hb.put(0);
+		put_int32(&hb,co->width);
+		put_int64(&hb,vo);
+		put_int64(&hb,co->count);
+		put_int64(&hb,oo);
+	}
+	hb.flush();
+
+	// Copy the arrays from the temporary files
+	pos=24+32*ncols;
+	for(std::vector<column>::iterator co=cols.begin();co!=cols.end();++co) {
+		copy(co->vf,fp,pos);
+		if(co->width==0) copy(co->of,fp,pos);
+	}
+}
+
+}
@@ -0,0 +1,133 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file column_output.hh
+ * \brief Header file for the column_output class, which writes statistics
+ * about Voronoi cells to a binary file of columns. */
+
+#ifndef VOROPP_COLUMN_OUTPUT_HH
+#define VOROPP_COLUMN_OUTPUT_HH
+
+#include <cstdio>
+#include <vector>
+
+#include "config.hh"
+#include "common.hh"
+#include "output_buffer.hh"
+#include "cell.hh"
+
+namespace voro {
+
+/** The eight characters at the start of a binary column file. */
+const char column_file_magic[8]={'V','O','R','O','C','O','L','S'};
+
+/** \brief Class for writing statistics about Voronoi cells to a binary file
+ * of columns.
+ *
+ * The statistics are chosen with the control characters of a custom output
+ * string (see the "-hc" option of the command-line utility), and each one is
+ * stored as a column, in the order that the characters first appear. Any
+ * other text in the string is ignored. Columns with a fixed number of values
+ * per cell are stored as one contiguous array. Columns that hold a list for
+ * each cell, such as the face areas, are stored as one array of all the
+ * values, together with an array of ncells+1 offsets into it, so that the
+ * values for cell k run from offset k to offset k+1. Floating point values are
+ * stored in single precision by default, which keeps more digits than the
+ * text output does.
+ *
+ * The file starts with a 24 byte header: the eight characters "VOROCOLS", a
+ * 32-bit version number (1), a 32-bit number of columns, and a 64-bit number
+ * of cells. A 32 byte entry for each column follows: the control character,
+ * the value type ('i' for 32-bit integers, 'f' for floats, or 'd' for
+ * doubles), two bytes of padding, a 32-bit number of values per cell (zero
+ * for lists), and 64-bit numbers giving the byte offset of the values, the
+ * number of values, and the byte offset of the 64-bit list offsets (zero for
+ * fixed columns). Every array starts on an eight byte boundary, so a
+ * memory-mapped file can be used directly, and all numbers are little-endian.
+ *
+ * The lists of the %t control character keep the layout of
+ * voronoicell_base::face_vertices(), giving each face's number of vertices
+ * followed by their indices. The vertex positions of %p and %P and the
+ * normals of %l are stored as consecutive triplets. */
+class column_output {
+	public:
+		/** The number of cells that have been added. This and the
+		 * other counts and file offsets are held as doubles, which
+		 * are exact up to 2^53, since C++98 has no 64-bit integer
+		 * type. */
+		double ncells;
+		column_output(const char *format,bool double_precision=false);
+		~column_output();
+		void add_cell(voronoicell_base &c,int i,double x,double y,double z,double r);
+		void write(FILE *fp);
+		/** Writes the columns to a file.
+		 * \param[in] filename the name of the file to write to. */
+		inline void write(const char *filename) {
+			FILE *fp=safe_fopen(filename,"wb");
+			write(fp);
+			fclose(fp);
+		}
+	private:
+		/** \brief The information about a single column. */
+		struct column {
+			/** The control character of the column. */
+			char code;
+			/** The value type, 'i', 'f', or 'd'. */
+			char type;
+			/** The number of values per cell, or zero for a
+			 * column of lists. */
+			int width;
+			/** The number of values written so far. */
+			double count;
+			/** The temporary file holding the values. */
+			FILE *vf;
+			/** The temporary file holding the list offsets. */
+			FILE *of;
+			/** The buffer for writing to the values file. */
+			output_buffer *vb;
+			/** The buffer for writing to the offsets file. */
+			output_buffer *ob;
+		};
+		/** The columns. */
+		std::vector<column> cols;
+		/** Whether numbers need to be byte-swapped, because the
+		 * machine is big-endian. */
+		bool swap;
+		/** A scratch vector of integers for the cell statistics. */
+		std::vector<int> vi;
+		/** A scratch vector of floating point numbers for the cell
+		 * statistics. */
+		std::vector<double> vd;
+		void put(column &co,const int *v,int n);
+		void put(column &co,const double *v,int n);
+		/** Adds an integer to a column.
+		 * \param[in] co the column.
+		 * \param[in] v the integer. */
+		inline void put(column &co,int v) {put(co,&v,1);}
+		/** Adds a floating point number to a column.
+		 * \param[in] co the column.
+		 * \param[in] v the number. */
+		inline void put(column &co,double v) {put(co,&v,1);}
+		/** Adds a vector of integers to a column.
+		 * \param[in] co the column.
+		 * \param[in] v the vector. */
+		inline void put(column &co,std::vector<int> &v) {
+			if(!v.empty()) put(co,&v[0],int(v.size()));
+		}
+		/** Adds a vector of floating point numbers to a column.
+		 * \param[in] co the column.
+		 * \param[in] v the vector. */
+		inline void put(column &co,std::vector<double> &v) {
+			if(!v.empty()) put(co,&v[0],int(v.size()));
+		}
+		void put_int32(output_buffer *b,unsigned int v);
+		void put_int64(output_buffer *b,double v);
+		void copy(FILE *src,FILE *fp,double &pos);
+};
+
+}
+
+#endif
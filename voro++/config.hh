@@ -29,6 +29,10 @@ const int init_marginal=64;
 const int init_delete_size=256;
 /** The initial size for the auxiliary delete stack. */
 const int init_delete2_size=256;
+/** The maximum vertex order held in the inline storage of the
+ * voronoicell_fixed and voronoicell_neighbor_fixed classes. Vertices of
+ * higher order are still allowed, but their memory comes from the heap. */
+const int fixed_vertex_order=16;
 /** The initial size for the wall pointer array. */
 const int init_wall_size=32;
 /** The default initial size for the ordering class. */
@@ -52,6 +56,10 @@ const int max_delete_size=16777216;
 const int max_delete2_size=16777216;
 /** The maximum amount of particle memory allocated for a single region. */
 const int max_particle_memory=16777216;
+/** When a container adds a particle slab or rebuilds its slabs, this sets the
+ * amount of free memory to leave for blocks that later need more space, as a
+ * fraction of the memory that the blocks are using. */
+const double particle_slab_spare=0.25;
 /** The maximum size for the wall pointer array. */
 const int max_wall_size=2048;
 /** The maximum size for the ordering class. */
@@ -73,6 +81,36 @@ const int pre_container_chunk_size=1024;
 #define VOROPP_VERBOSE 0
 #endif
 
+#ifndef VOROPP_SOA_PARTICLES
+/** If this macro is nonzero, the container classes store the particles in
+ * each block as separate runs of x, y, z (and r) coordinates, instead of
+ * interleaving the coordinates of each particle. See particle_layout.hh. */
+#define VOROPP_SOA_PARTICLES 0
+#endif
+
+#ifndef VOROPP_PARTICLE_SLABS
+/** If this macro is nonzero, the container_base class keeps the particles of
+ * its blocks in a few large arrays (slabs), instead of allocating separate
+ * arrays for each block. A block that needs more memory is moved to the free
+ * space at the end of the last slab, and the slabs are rebuilt as one once
+ * more than half of their memory is unused. This makes setting up and freeing
+ * a container with many blocks much faster, and keeps neighboring blocks next
+ * to each other in memory. */
+#define VOROPP_PARTICLE_SLABS 1
+#endif
+
+#ifndef VOROPP_EXACT_PREDICATES
+/** If this macro is nonzero, the plane cutting routines use a tolerance that
+ * is relative to the size of the terms in each plane test, instead of the
+ * fixed tolerance below, which stops working once particles are closer than
+ * about 1e-9. The plain floating point test settles almost all cases, and
+ * vertices close to the plane are then classified with error-free arithmetic.
+ * See the relative_tolerance constant. The fixed tolerance handles inputs that
+ * are perturbed from a degenerate arrangement by less than about 1e-12 better,
+ * since it snaps them back to the arrangement. */
+#define VOROPP_EXACT_PREDICATES 0
+#endif
+
 /** If a point is within this distance of a cutting plane, then the code
  * assumes that point exactly lies on the plane. */
 const double tolerance=1e-11;
@@ -87,6 +125,18 @@ const double tolerance2=2e-11;
  * quantities are large enough to be used. */
 const double tolerance_sq=tolerance*tolerance;
 
+/** When VOROPP_EXACT_PREDICATES is set, a point is assumed to lie exactly on a
+ * cutting plane if the scalar product used to test it is within this multiple
+ * of the sum of the magnitudes of the product's terms. This takes the place of
+ * tolerance, and since it scales with the separation between the particles,
+ * the cells of very close particles are resolved as well as any others. It is
+ * 128 times the machine epsilon, well above the rounding error of the test. */
+const double relative_tolerance=2.842170943040401e-14;
+
+/** When VOROPP_EXACT_PREDICATES is set, this plays the role of tolerance2,
+ * as a multiple of the sum of the magnitudes of the terms in the test. */
+const double relative_tolerance2=2*relative_tolerance;
+
 /** A large number that is used in the computation. */
 const double large_number=1e30;
 
@@ -100,6 +150,31 @@ const int max_unit_voro_shells=10;
  * container grid. */
 const double optimal_particles=5.6;
 
+/** The number of contiguous block ranges per thread that the parallel
+ * computation routines split a container into. Using several ranges per
+ * thread evens out the load when particles are unevenly distributed. */
+const int parallel_chunks_per_thread=8;
+
+/** If VOROPP_REFRESH_MRS is nonzero, blocks with at least this many particles
+ * have the maximum radius of the cell recomputed while they are being tested,
+ * once every refresh_mrs_interval particles. */
+const int refresh_mrs_particles=16;
+
+/** The number of particles tested between recomputations of the maximum
+ * radius of the cell in a crowded block (see refresh_mrs_particles). */
+const int refresh_mrs_interval=8;
+
+#ifndef VOROPP_REFRESH_MRS
+/** If this macro is nonzero, the maximum radius of a cell is recomputed while
+ * crowded blocks are being tested (see refresh_mrs_particles). The cell
+ * shrinks a lot while such a block is being tested, so this saves many plane
+ * cuts that can't possibly intersect the cell. However, the plane cuts are
+ * then made in a different order, so the vertices, faces, and neighbors of
+ * some cells are listed in a different order than usual. Volumes and other
+ * totals are unaffected. */
+#define VOROPP_REFRESH_MRS 0
+#endif
+
 /** If this is set to 1, then the code reports any instances of particles being
  * put outside of the container geometry. */
 #define VOROPP_REPORT_OUT_OF_BOUNDS 0
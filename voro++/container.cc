@@ -9,6 +9,9 @@
 
 #include "container.hh"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace voro {
 
@@ -37,15 +40,29 @@ container_base::container_base(double ax_,double bx_,double ay_,double by_,doubl
 	int l;
 	for(l=0;l<nxyz;l++) co[l]=0;
 	for(l=0;l<nxyz;l++) mem[l]=init_mem;
+#if VOROPP_PARTICLE_SLABS
+	slab_total=0;
+	add_slab(static_cast<size_t>(nxyz)*init_mem);
+	for(l=0;l<nxyz;l++) {
+		id[l]=id_slabs[0]+static_cast<size_t>(l)*init_mem;
+		p[l]=p_slabs[0]+static_cast<size_t>(ps)*l*init_mem;
+	}
+	slab_used=slab_live=slab_mem;
+#else
 	for(l=0;l<nxyz;l++) id[l]=new int[init_mem];
 	for(l=0;l<nxyz;l++) p[l]=new double[ps*init_mem];
+#endif
 }
 
 /** The container destructor frees the dynamically allocated memory. */
 container_base::~container_base() {
+#if VOROPP_PARTICLE_SLABS
+	free_slabs();
+#else
 	int l;
 	for(l=0;l<nxyz;l++) delete [] p[l];
 	for(l=0;l<nxyz;l++) delete [] id[l];
+#endif
 	delete [] id;
 	delete [] p;
 	delete [] co;
@@ -80,7 +97,7 @@ container::container(double ax_,double bx_,double ay_,double by_,double az_,doub
 container_poly::container_poly(double ax_,double bx_,double ay_,double by_,double az_,double bz_,
 	int nx_,int ny_,int nz_,bool xperiodic_,bool yperiodic_,bool zperiodic_,int init_mem)
 	: container_base(ax_,bx_,ay_,by_,az_,bz_,nx_,ny_,nz_,xperiodic_,yperiodic_,zperiodic_,init_mem,4),
-	vc(*this,xperiodic_?2*nx_+1:nx_,yperiodic_?2*ny_+1:ny_,zperiodic_?2*nz_+1:nz_) {ppr=p;}
+	vc(*this,xperiodic_?2*nx_+1:nx_,yperiodic_?2*ny_+1:ny_,zperiodic_?2*nz_+1:nz_) {ppr=p;pmem=mem;}
 
 /** Put a particle into the correct region of the container.
  * \param[in] n the numerical ID of the inserted particle.
@@ -89,8 +106,7 @@ void container::put(int n,double x,double y,double z) {
 	int ijk;
 	if(put_locate_block(ijk,x,y,z)) {
 		id[ijk][co[ijk]]=n;
-		double *pp=p[ijk]+3*co[ijk]++;
-		*(pp++)=x;*(pp++)=y;*pp=z;
+		put_coords(ijk,co[ijk]++,x,y,z);
 	}
 }
 
@@ -104,8 +120,7 @@ bool container::put(int n,double x,double y,double z, int &ijk, int &q) {
     if(put_locate_block(ijk,x,y,z)) {
         q = co[ijk];
         id[ijk][co[ijk]]=n;
-        double *pp=p[ijk]+3*co[ijk]++;
-        *(pp++)=x;*(pp++)=y;*pp=z;
+        put_coords(ijk,co[ijk]++,x,y,z);
         return true;
     }
     return false;
@@ -122,11 +137,7 @@ int container::swapnpop(int ijk, int q) {
     int toret = -1;
     if (q != lasti) {
         toret = id[ijk][q] = id[ijk][lasti];
-        double *ppq = p[ijk]+3*q;
-        double *ppl = p[ijk]+3*lasti;
-        *(ppq++) = *(ppl++); // x
-        *(ppq++) = *(ppl++); // y
-        *(ppq++) = *(ppl++); // z
+        for (int c=0; c<3; c++) pc(ijk,q,c) = pc(ijk,lasti,c);
     }
     co[ijk]--;
     return toret;
@@ -152,8 +163,7 @@ int container::move(int &ijk, int &q, int n, double x, double y, double z, int &
     int ijk_new;
     if (put_remap(ijk_new, x, y, z)) {
         if (ijk_new == ijk) { // same block, can just update position and be done
-            double *pp = p[ijk]+3*q;
-            *(pp++)=x;*(pp++)=y;*pp=z;
+            put_coords(ijk,q,x,y,z);
         } else {
             int n = id[ijk][q]; // save original id
             needsupdate_q = q; // save original q
@@ -165,8 +175,7 @@ int container::move(int &ijk, int &q, int n, double x, double y, double z, int &
             if(co[ijk_new]==mem[ijk_new]) add_particle_memory(ijk_new);
             int q_new = co[ijk_new];
             id[ijk_new][co[ijk_new]] = n;
-            double *pp=p[ijk_new]+3*co[ijk_new]++;
-            *(pp++)=x;*(pp++)=y;*pp=z;
+            put_coords(ijk_new,co[ijk_new]++,x,y,z);
             
             // update ijk and q
             q = q_new;
@@ -190,8 +199,8 @@ void container_poly::put(int n,double x,double y,double z,double r) {
 	int ijk;
 	if(put_locate_block(ijk,x,y,z)) {
 		id[ijk][co[ijk]]=n;
-		double *pp=p[ijk]+4*co[ijk]++;
-		*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
+		pc(ijk,co[ijk],3)=r;
+		put_coords(ijk,co[ijk]++,x,y,z);
 		if(max_radius<r) max_radius=r;
 	}
 }
@@ -206,8 +215,7 @@ void container::put(particle_order &vo,int n,double x,double y,double z) {
 	if(put_locate_block(ijk,x,y,z)) {
 		id[ijk][co[ijk]]=n;
 		vo.add(ijk,co[ijk]);
-		double *pp=p[ijk]+3*co[ijk]++;
-		*(pp++)=x;*(pp++)=y;*pp=z;
+		put_coords(ijk,co[ijk]++,x,y,z);
 	}
 }
 
@@ -222,8 +230,8 @@ void container_poly::put(particle_order &vo,int n,double x,double y,double z,dou
 	if(put_locate_block(ijk,x,y,z)) {
 		id[ijk][co[ijk]]=n;
 		vo.add(ijk,co[ijk]);
-		double *pp=p[ijk]+4*co[ijk]++;
-		*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
+		pc(ijk,co[ijk],3)=r;
+		put_coords(ijk,co[ijk]++,x,y,z);
 		if(max_radius<r) max_radius=r;
 	}
 }
@@ -317,12 +325,13 @@ int container_base::already_in_container(double x, double y, double z, double th
                 off[2] = offs[2][k];
                 double xx = x, yy = y, zz = z;
                 if(put_remap_with_offset(ijk,xx,yy,zz,off)) {
+                    const double *px = &pc(ijk,0,0), *py = &pc(ijk,0,1), *pz = &pc(ijk,0,2);
+                    const int st = particle_layout::step(ps);
                     for (int ii=0; ii<co[ijk]; ii++) {
                         if (id[ijk][ii] == except_cell) { continue; }
-                        double *pp = p[ijk]+ii*ps;
-                        double dx = *(pp++) - xx;
-                        double dy = *(pp++) - yy;
-                        double dz = *(pp++) - zz;
+                        double dx = px[ii*st] - xx;
+                        double dy = py[ii*st] - yy;
+                        double dz = pz[ii*st] - zz;
                         double dsq = dx*dx+dy*dy+dz*dz;
                         if (dsq < threshold) { return id[ijk][ii]; }
                     }
@@ -338,12 +347,13 @@ int container_base::already_in_block(double x, double y, double z, double thresh
     int ijk;
     
     if(put_remap(ijk,x,y,z)) {
+        const double *px = &pc(ijk,0,0), *py = &pc(ijk,0,1), *pz = &pc(ijk,0,2);
+        const int st = particle_layout::step(ps);
         for (int i=0; i<co[ijk]; i++) {
             if (id[ijk][i] == except_cell) { continue; }
-            double *pp = p[ijk]+i*ps;
-            double dx = *(pp++) - x;
-            double dy = *(pp++) - y;
-            double dz = *(pp++) - z;
+            double dx = px[i*st] - x;
+            double dy = py[i*st] - y;
+            double dz = pz[i*st] - z;
             double dsq = dx*dx+dy*dy+dz*dz;
             if (dsq < threshold) { return id[ijk][i]; }
         }
@@ -412,9 +422,9 @@ bool container::find_voronoi_cell(double x,double y,double z,double &rx,double &
 		if(xperiodic) {ci+=w.di;if(ci<0||ci>=nx) ai+=step_div(ci,nx);}
 		if(yperiodic) {cj+=w.dj;if(cj<0||cj>=ny) aj+=step_div(cj,ny);}
 		if(zperiodic) {ck+=w.dk;if(ck<0||ck>=nz) ak+=step_div(ck,nz);}
-		rx=p[w.ijk][3*w.l]+ai*(bx-ax);
-		ry=p[w.ijk][3*w.l+1]+aj*(by-ay);
-		rz=p[w.ijk][3*w.l+2]+ak*(bz-az);
+		rx=pc(w.ijk,w.l,0)+ai*(bx-ax);
+		ry=pc(w.ijk,w.l,1)+aj*(by-ay);
+		rz=pc(w.ijk,w.l,2)+ak*(bz-az);
 		pid=id[w.ijk][w.l];
 		return true;
 	}
@@ -450,9 +460,9 @@ bool container_poly::find_voronoi_cell(double x,double y,double z,double &rx,dou
 		if(xperiodic) {ci+=w.di;if(ci<0||ci>=nx) ai+=step_div(ci,nx);}
 		if(yperiodic) {cj+=w.dj;if(cj<0||cj>=ny) aj+=step_div(cj,ny);}
 		if(zperiodic) {ck+=w.dk;if(ck<0||ck>=nz) ak+=step_div(ck,nz);}
-		rx=p[w.ijk][4*w.l]+ai*(bx-ax);
-		ry=p[w.ijk][4*w.l+1]+aj*(by-ay);
-		rz=p[w.ijk][4*w.l+2]+ak*(bz-az);
+		rx=pc(w.ijk,w.l,0)+ai*(bx-ax);
+		ry=pc(w.ijk,w.l,1)+aj*(by-ay);
+		rz=pc(w.ijk,w.l,2)+ak*(bz-az);
 		pid=id[w.ijk][w.l];
 		return true;
 	}
@@ -464,7 +474,16 @@ bool container_poly::find_voronoi_cell(double x,double y,double z,double &rx,dou
 /** Increase memory for a particular region.
  * \param[in] i the index of the region to reallocate. */
 void container_base::add_particle_memory(int i) {
-	int l,nmem=mem[i]<<1;
+	set_particle_memory(i,mem[i]<<1);
+}
+
+/** Sets the memory for a particular region to a given number of particles,
+ * copying in the particles that it already holds.
+ * \param[in] i the index of the region to reallocate.
+ * \param[in] nmem the number of particles to allocate memory for, which must
+ *                 be at least the number already stored in the region. */
+void container_base::set_particle_memory(int i,int nmem) {
+	int l;
 
 	// Carry out a check on the memory allocation size, and
 	// print a status message if requested
@@ -474,28 +493,127 @@ void container_base::add_particle_memory(int i) {
 	fprintf(stderr,"Particle memory in region %d scaled up to %d\n",i,nmem);
 #endif
 
-	// Allocate new memory and copy in the contents of the old arrays
+#if VOROPP_PARTICLE_SLABS
+	// Take memory for the region from the free space at the end of the
+	// last slab, leaving its old memory unused. If there isn't enough free
+	// space then either add another slab, or if more than half of the
+	// memory in the slabs is unused, rebuild them as a single slab.
+	if(slab_mem-slab_used<static_cast<size_t>(nmem)) {
+		if(slab_total-slab_live>slab_live) {
+			std::vector<int> nm(mem,mem+nxyz);
+			nm[i]=nmem;
+			rebuild_slabs(&nm[0],particle_slab_spare);
+			return;
+		}
+		size_t m=static_cast<size_t>(particle_slab_spare*slab_live);
+		add_slab(m>static_cast<size_t>(nmem)?m:nmem);
+	}
+	int *idp=id_slabs.back()+slab_used;
+	double *pp=p_slabs.back()+ps*slab_used;
+	slab_used+=nmem;
+	slab_live+=nmem-mem[i];
+#else
 	int *idp=new int[nmem];
-	for(l=0;l<co[i];l++) idp[l]=id[i][l];
 	double *pp=new double[ps*nmem];
-	for(l=0;l<ps*co[i];l++) pp[l]=p[i][l];
+#endif
+
+	// Copy in the contents of the old arrays
+	for(l=0;l<co[i];l++) idp[l]=id[i][l];
+	particle_layout::grow(pp,p[i],ps,co[i],mem[i],nmem);
 
 	// Update pointers and delete old arrays
 	mem[i]=nmem;
-	delete [] id[i];id[i]=idp;
-	delete [] p[i];p[i]=pp;
+#if !VOROPP_PARTICLE_SLABS
+	delete [] id[i];
+	delete [] p[i];
+#endif
+	id[i]=idp;p[i]=pp;
 }
 
+/** Sets the memory for every region at once, to at least a given number of
+ * particles for each. Regions that already have enough memory keep it.
+ * \param[in] nmem an array giving the number of particles to allocate memory
+ *                 for in each region. */
+void container_base::set_particle_memory(const int *nmem) {
+#if VOROPP_PARTICLE_SLABS
+	// Add up the memory for the regions that need to grow, and make sure
+	// that the last slab has room for all of them, so that they are
+	// placed next to each other in a single new slab if necessary
+	size_t m=0;
+	for(int l=0;l<nxyz;l++) if(nmem[l]>mem[l]) m+=nmem[l];
+	if(slab_mem-slab_used<m) add_slab(m);
+#endif
+	for(int l=0;l<nxyz;l++) if(nmem[l]>mem[l]) set_particle_memory(l,nmem[l]);
+}
+
+#if VOROPP_PARTICLE_SLABS
+/** Adds a slab to the end of the list, and makes it the one that new memory
+ * for the blocks is taken from.
+ * \param[in] m the number of particles to allocate memory for. */
+void container_base::add_slab(size_t m) {
+#if VOROPP_VERBOSE >=3
+	fprintf(stderr,"Particle slab added with memory for %lu particles\n",(unsigned long) m);
+#endif
+	id_slabs.push_back(new int[m]);
+	p_slabs.push_back(new double[ps*m]);
+	slab_mem=m;slab_used=0;slab_total+=m;
+}
+
+/** Frees all of the slabs. */
+void container_base::free_slabs() {
+	for(size_t k=0;k<id_slabs.size();k++) {
+		delete [] p_slabs[k];
+		delete [] id_slabs[k];
+	}
+	id_slabs.clear();p_slabs.clear();
+	slab_total=0;
+}
+
+/** Replaces the slabs with a single new slab, copying every block into it in
+ * order with a new amount of memory for each. This reclaims any memory that
+ * the blocks had stopped using.
+ * \param[in] nmem an array giving the number of particles to allocate memory
+ *                 for in each block, which must be at least the number
+ *                 already stored there.
+ * \param[in] spare the amount of free memory to leave at the end of the new
+ *                  slab, as a fraction of the memory given to the blocks. */
+void container_base::rebuild_slabs(const int *nmem,double spare) {
+	size_t tot=0;
+	for(int l=0;l<nxyz;l++) tot+=nmem[l];
+	size_t nsm=tot+static_cast<size_t>(spare*tot);
+#if VOROPP_VERBOSE >=3
+	fprintf(stderr,"Particle slabs rebuilt with memory for %lu particles\n",(unsigned long) nsm);
+#endif
+
+	// Copy each block into the new arrays, directly after the previous
+	// one
+	int *nid=new int[nsm],*idp=nid;
+	double *np=new double[ps*nsm],*pp=np;
+	for(int l=0;l<nxyz;l++) {
+		for(int j=0;j<co[l];j++) idp[j]=id[l][j];
+		particle_layout::grow(pp,p[l],ps,co[l],mem[l],nmem[l]);
+		id[l]=idp;p[l]=pp;mem[l]=nmem[l];
+		idp+=nmem[l];pp+=ps*nmem[l];
+	}
+
+	// Replace the old slabs
+	free_slabs();
+	id_slabs.push_back(nid);p_slabs.push_back(np);
+	slab_mem=slab_total=nsm;
+	slab_used=slab_live=tot;
+}
+#endif
+
 /** Import a list of particles from an open file stream into the container.
  * Entries of four numbers (Particle ID, x position, y position, z position)
  * are searched for. If the file cannot be successfully read, then the routine
  * causes a fatal error.
  * \param[in] fp the file handle to read from. */
 void container::import(FILE *fp) {
-	int i,j;
-	double x,y,z;
-	while((j=fscanf(fp,"%d %lg %lg %lg",&i,&x,&y,&z))==4) put(i,x,y,z);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_reader pr(fp,3);
+	int i;
+	double v[3];
+	while(pr.next(i,v)) put(i,v[0],v[1],v[2]);
 }
 
 /** Import a list of particles from an open file stream, also storing the order
@@ -505,10 +623,10 @@ void container::import(FILE *fp) {
  * \param[in,out] vo a reference to an ordering class to use.
  * \param[in] fp the file handle to read from. */
 void container::import(particle_order &vo,FILE *fp) {
-	int i,j;
-	double x,y,z;
-	while((j=fscanf(fp,"%d %lg %lg %lg",&i,&x,&y,&z))==4) put(vo,i,x,y,z);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_reader pr(fp,3);
+	int i;
+	double v[3];
+	while(pr.next(i,v)) put(vo,i,v[0],v[1],v[2]);
 }
 
 /** Import a list of particles from an open file stream into the container.
@@ -517,10 +635,10 @@ void container::import(particle_order &vo,FILE *fp) {
  * routine causes a fatal error.
  * \param[in] fp the file handle to read from. */
 void container_poly::import(FILE *fp) {
-	int i,j;
-	double x,y,z,r;
-	while((j=fscanf(fp,"%d %lg %lg %lg %lg",&i,&x,&y,&z,&r))==5) put(i,x,y,z,r);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_reader pr(fp,4);
+	int i;
+	double v[4];
+	while(pr.next(i,v)) put(i,v[0],v[1],v[2],v[3]);
 }
 
 /** Import a list of particles from an open file stream, also storing the order
@@ -530,10 +648,10 @@ void container_poly::import(FILE *fp) {
  * \param[in,out] vo a reference to an ordering class to use.
  * \param[in] fp the file handle to read from. */
 void container_poly::import(particle_order &vo,FILE *fp) {
-	int i,j;
-	double x,y,z,r;
-	while((j=fscanf(fp,"%d %lg %lg %lg %lg",&i,&x,&y,&z,&r))==5) put(vo,i,x,y,z,r);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_reader pr(fp,4);
+	int i;
+	double v[4];
+	while(pr.next(i,v)) put(vo,i,v[0],v[1],v[2],v[3]);
 }
 
 /** Outputs the a list of all the container regions along with the number of
@@ -637,6 +755,241 @@ double container_poly::sum_cell_volumes() {
 	return vol;
 }
 
+/** Returns the number of threads that the parallel routines will use. This is
+ * one unless the library was compiled with OpenMP support. */
+static inline int parallel_threads() {
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+/** Splits the blocks of a container into contiguous ranges holding roughly
+ * equal numbers of particles, for the parallel routines to share out between
+ * threads. Since the ranges are in block order, results that are gathered
+ * range by range come out in the same order as a c_loop_all would visit the
+ * particles.
+ * \param[in] con the container to consider.
+ * \param[out] br the range boundaries; range n covers blocks br[n] to
+ *                br[n+1]-1.
+ * \return The number of ranges. */
+static int parallel_block_ranges(container_base &con,std::vector<int> &br) {
+	int ijk,tp=0,nr=parallel_chunks_per_thread*parallel_threads(),acc=0;
+	for(ijk=0;ijk<con.nxyz;ijk++) tp+=con.co[ijk];
+	if(nr>tp) nr=tp>0?tp:1;
+	br.clear();br.push_back(0);
+	for(ijk=0;ijk<con.nxyz;ijk++) {
+		acc+=con.co[ijk];
+		if(int(br.size())<nr&&double(acc)*nr>=double(tp)*int(br.size())&&ijk+1<con.nxyz) br.push_back(ijk+1);
+	}
+	br.push_back(con.nxyz);
+	return br.size()-1;
+}
+
+/** Opens a temporary file for each block range, for threads to write their
+ * output to.
+ * \param[out] tf the vector of file handles to fill.
+ * \param[in] nr the number of block ranges. */
+static void parallel_open_chunks(std::vector<FILE*> &tf,int nr) {
+	tf.resize(nr);
+	for(int n=0;n<nr;n++) {
+		tf[n]=tmpfile();
+		if(tf[n]==NULL) voro_fatal_error("Unable to open temporary file for parallel output",VOROPP_FILE_ERROR);
+	}
+}
+
+/** Copies the output of each block range to a file in order, and closes the
+ * temporary files.
+ * \param[in] tf the temporary files.
+ * \param[in] fp a file handle to write to. */
+static void parallel_merge_chunks(std::vector<FILE*> &tf,FILE *fp) {
+	char buf[65536];size_t l;
+	for(unsigned int n=0;n<tf.size();n++) {
+		rewind(tf[n]);
+		while((l=fread(buf,1,sizeof(buf),tf[n]))>0) fwrite(buf,1,l,fp);
+		fclose(tf[n]);
+	}
+}
+
+/** Computes all of the Voronoi cells in a container on multiple threads, but
+ * does nothing with the output.
+ * \param[in] con the container to consider. */
+template<class c_class>
+static void parallel_compute_all_cells(c_class &con) {
+	std::vector<int> br;
+	int nr=parallel_block_ranges(con,br);
+#pragma omp parallel
+	{
+		voronoicell_fixed<> c;
+		voro_compute_context<c_class> vcc(con);
+#pragma omp for schedule(dynamic)
+		for(int n=0;n<nr;n++) for(int ijk=br[n];ijk<br[n+1];ijk++)
+			for(int q=0;q<con.co[ijk];q++) con.compute_cell(c,ijk,q,vcc);
+	}
+}
+
+/** Computes all of the Voronoi cells in a container on multiple threads and
+ * sums their volumes. The volumes are added up in the same order as the
+ * serial routine, so the result is identical.
+ * \param[in] con the container to consider.
+ * \return The sum of all of the computed Voronoi volumes. */
+template<class c_class>
+static double parallel_sum_cell_volumes(c_class &con) {
+	std::vector<int> br;
+	int nr=parallel_block_ranges(con,br);
+	std::vector<std::vector<double> > vols(nr);
+#pragma omp parallel
+	{
+		voronoicell_fixed<> c;
+		voro_compute_context<c_class> vcc(con);
+#pragma omp for schedule(dynamic)
+		for(int n=0;n<nr;n++) for(int ijk=br[n];ijk<br[n+1];ijk++)
+			for(int q=0;q<con.co[ijk];q++) if(con.compute_cell(c,ijk,q,vcc)) vols[n].push_back(c.volume());
+	}
+	double vol=0;
+	for(int n=0;n<nr;n++) for(unsigned int i=0;i<vols[n].size();i++) vol+=vols[n][i];
+	return vol;
+}
+
+/** Computes all of the Voronoi cells in a container on multiple threads and
+ * saves the output in gnuplot format. Each block range is written to its own
+ * temporary file, and these are merged in order, so the output is identical
+ * to the serial routine.
+ * \param[in] con the container to consider.
+ * \param[in] fp a file handle to write to. */
+template<class c_class>
+static void parallel_draw_cells_gnuplot(c_class &con,FILE *fp) {
+	std::vector<int> br;std::vector<FILE*> tf;
+	int nr=parallel_block_ranges(con,br);
+	parallel_open_chunks(tf,nr);
+#pragma omp parallel
+	{
+		voronoicell_fixed<> c;
+		voro_compute_context<c_class> vcc(con);
+#pragma omp for schedule(dynamic)
+		for(int n=0;n<nr;n++) for(int ijk=br[n];ijk<br[n+1];ijk++)
+			for(int q=0;q<con.co[ijk];q++) if(con.compute_cell(c,ijk,q,vcc))
+				c.draw_gnuplot(con.pc(ijk,q,0),con.pc(ijk,q,1),con.pc(ijk,q,2),tf[n]);
+	}
+	parallel_merge_chunks(tf,fp);
+}
+
+/** Computes all of the Voronoi cells in a container on multiple threads and
+ * saves customized information about them. Each block range is written to its
+ * own temporary file, and these are merged in order, so the output is
+ * identical to the serial routine.
+ * \param[in] con the container to consider.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+template<class c_class,class v_cell>
+static void parallel_print_custom(c_class &con,const char *format,FILE *fp) {
+	std::vector<int> br;std::vector<FILE*> tf;
+	int nr=parallel_block_ranges(con,br);
+	custom_format cf(format);
+	parallel_open_chunks(tf,nr);
+#pragma omp parallel
+	{
+		v_cell c;
+		voro_compute_context<c_class> vcc(con);
+#pragma omp for schedule(dynamic)
+		for(int n=0;n<nr;n++) {
+			output_buffer ob(tf[n]);
+			for(int ijk=br[n];ijk<br[n+1];ijk++)
+				for(int q=0;q<con.co[ijk];q++) if(con.compute_cell(c,ijk,q,vcc))
+					c.output_custom(cf,con.id[ijk][q],con.pc(ijk,q,0),con.pc(ijk,q,1),con.pc(ijk,q,2),
+							con.ps==3?default_radius:con.pc(ijk,q,3),ob);
+		}
+	}
+	parallel_merge_chunks(tf,fp);
+}
+
+/** Computes all of the Voronoi cells in the container using multiple threads,
+ * but does nothing with the output. Threads are only used if the library is
+ * compiled with OpenMP support. */
+void container::compute_all_cells_parallel() {
+	if(parallel_threads()>1) parallel_compute_all_cells(*this);
+	else compute_all_cells();
+}
+
+/** Computes all of the Voronoi cells in the container using multiple threads,
+ * but does nothing with the output. Threads are only used if the library is
+ * compiled with OpenMP support. */
+void container_poly::compute_all_cells_parallel() {
+	if(parallel_threads()>1) parallel_compute_all_cells(*this);
+	else compute_all_cells();
+}
+
+/** Calculates all of the Voronoi cells using multiple threads and sums their
+ * volumes. The result is identical to that of sum_cell_volumes.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container::sum_cell_volumes_parallel() {
+	return parallel_threads()>1?parallel_sum_cell_volumes(*this):sum_cell_volumes();
+}
+
+/** Calculates all of the Voronoi cells using multiple threads and sums their
+ * volumes. The result is identical to that of sum_cell_volumes.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container_poly::sum_cell_volumes_parallel() {
+	return parallel_threads()>1?parallel_sum_cell_volumes(*this):sum_cell_volumes();
+}
+
+/** Computes all Voronoi cells using multiple threads and saves the output in
+ * gnuplot format, identical to that of draw_cells_gnuplot.
+ * \param[in] fp a file handle to write to. */
+void container::draw_cells_gnuplot_parallel(FILE *fp) {
+	if(parallel_threads()>1) parallel_draw_cells_gnuplot(*this,fp);
+	else draw_cells_gnuplot(fp);
+}
+
+/** Computes all Voronoi cells using multiple threads and saves the output in
+ * gnuplot format, identical to that of draw_cells_gnuplot.
+ * \param[in] fp a file handle to write to. */
+void container_poly::draw_cells_gnuplot_parallel(FILE *fp) {
+	if(parallel_threads()>1) parallel_draw_cells_gnuplot(*this,fp);
+	else draw_cells_gnuplot(fp);
+}
+
+/** Computes all the Voronoi cells using multiple threads and saves customized
+ * information about them, identical to that of print_custom.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container::print_custom_parallel(const char *format,FILE *fp) {
+	if(parallel_threads()<=1) print_custom(format,fp);
+	else if(contains_neighbor(format)) parallel_print_custom<container,voronoicell_neighbor_fixed<> >(*this,format,fp);
+	else parallel_print_custom<container,voronoicell_fixed<> >(*this,format,fp);
+}
+
+/** Computes all the Voronoi cells using multiple threads and saves customized
+ * information about them, identical to that of print_custom.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_poly::print_custom_parallel(const char *format,FILE *fp) {
+	if(parallel_threads()<=1) print_custom(format,fp);
+	else if(contains_neighbor(format)) parallel_print_custom<container_poly,voronoicell_neighbor_fixed<> >(*this,format,fp);
+	else parallel_print_custom<container_poly,voronoicell_fixed<> >(*this,format,fp);
+}
+
+/** Computes all the Voronoi cells using multiple threads and saves customized
+ * information about them, identical to that of print_custom.
+ * \param[in] format the custom output string to use.
+ * \param[in] filename the name of the file to write to. */
+void container::print_custom_parallel(const char *format,const char *filename) {
+	FILE *fp=safe_fopen(filename,"w");
+	print_custom_parallel(format,fp);
+	fclose(fp);
+}
+
+/** Computes all the Voronoi cells using multiple threads and saves customized
+ * information about them, identical to that of print_custom.
+ * \param[in] format the custom output string to use.
+ * \param[in] filename the name of the file to write to. */
+void container_poly::print_custom_parallel(const char *format,const char *filename) {
+	FILE *fp=safe_fopen(filename,"w");
+	print_custom_parallel(format,fp);
+	fclose(fp);
+}
+
 /** This function tests to see if a given vector lies within the container
  * bounds and any walls.
  * \param[in] (x,y,z) the position vector to be tested.
@@ -20,6 +20,8 @@
 #include "c_loops.hh"
 #include "v_compute.hh"
 #include "rad_option.hh"
+#include "particle_layout.hh"
+#include "particle_reader.hh"
 
 #include <cassert>
 #include <iostream>
@@ -162,6 +164,21 @@ class container_base : public voro_base, public wall_list {
 		 * class container_poly, then this is set to 4, to also hold
 		 * the particle radii. */
 		const int ps;
+		/** Returns a reference to one coordinate of a particle, in the
+		 * layout set by the particle_layout storage policy.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] l the index of the particle within the block.
+		 * \param[in] c the coordinate (0 to 3 for x, y, z and r). */
+		inline double &pc(int ijk,int l,int c) {
+			return p[ijk][particle_layout::at(ps,mem[ijk],l,c)];
+		}
+		/** Stores the position of a particle within a block.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] l the index of the particle within the block.
+		 * \param[in] (x,y,z) the position vector of the particle. */
+		inline void put_coords(int ijk,int l,double x,double y,double z) {
+			pc(ijk,l,0)=x;pc(ijk,l,1)=y;pc(ijk,l,2)=z;
+		}
 		container_base(double ax_,double bx_,double ay_,double by_,double az_,double bz_,
 				int nx_,int ny_,int nz_,bool xperiodic_,bool yperiodic_,bool zperiodic_,
 				int init_mem,int ps_);
@@ -192,8 +209,8 @@ class container_base : public voro_base, public wall_list {
 		template<class v_cell>
 		inline bool initialize_voronoicell(v_cell &c,int ijk,int q,int ci,int cj,int ck,
 				int &i,int &j,int &k,double &x,double &y,double &z,int &disp) {
-			double x1,x2,y1,y2,z1,z2,*pp=p[ijk]+ps*q;
-			x=*(pp++);y=*(pp++);z=*pp;
+			double x1,x2,y1,y2,z1,z2;
+			x=pc(ijk,q,0);y=pc(ijk,q,1);z=pc(ijk,q,2);
 			if(xperiodic) {x1=-(x2=0.5*(bx-ax));i=nx;} else {x1=ax-x;x2=bx-x;i=ci;}
 			if(yperiodic) {y1=-(y2=0.5*(by-ay));j=ny;} else {y1=ay-y;y2=by-y;j=cj;}
 			if(zperiodic) {z1=-(z2=0.5*(bz-az));k=nz;} else {z1=az-z;z2=bz-z;k=ck;}
@@ -278,10 +295,37 @@ class container_base : public voro_base, public wall_list {
     
 	protected:
 		void add_particle_memory(int i);
+		void set_particle_memory(int i,int nmem);
+		void set_particle_memory(const int *nmem);
 		bool put_locate_block(int &ijk,double &x,double &y,double &z);
 		inline bool put_remap(int &ijk,double &x,double &y,double &z);
         inline bool put_remap_with_offset(int &ijk,double &x,double &y,double &z, int off[3]);
 		inline bool remap(int &ai,int &aj,int &ak,int &ci,int &cj,int &ck,double &x,double &y,double &z,int &ijk);
+		friend class pre_container_base;
+#if VOROPP_PARTICLE_SLABS
+	private:
+		/** The arrays holding the particle IDs of the blocks, which
+		 * the entries of id point into. */
+		std::vector<int*> id_slabs;
+		/** The arrays holding the particle positions of the blocks,
+		 * which the entries of p point into. */
+		std::vector<double*> p_slabs;
+		/** The number of particles that the last slab has memory
+		 * for. */
+		size_t slab_mem;
+		/** The number of particles of memory in the last slab that
+		 * have been given to blocks. Memory past this point is free. */
+		size_t slab_used;
+		/** The number of particles that all of the slabs together
+		 * have memory for. */
+		size_t slab_total;
+		/** The number of particles of slab memory that the blocks
+		 * currently use, which is the sum of the mem array. */
+		size_t slab_live;
+		void add_slab(size_t m);
+		void free_slabs();
+		void rebuild_slabs(const int *nmem,double spare);
+#endif
 };
 
 /** \brief Extension of the container_base class for computing regular Voronoi
@@ -292,6 +336,9 @@ class container_base : public voro_base, public wall_list {
  * dependence on particle radii. */
 class container : public container_base, public radius_mono {
 	public:
+		/** The radius option class, which voro_compute keeps its own
+		 * copy of during a cell computation. */
+		typedef radius_mono r_option;
 		container(double ax_,double bx_,double ay_,double by_,double az_,double bz_,
 				int nx_,int ny_,int nz_,bool xperiodic_,bool yperiodic_,bool zperiodic_,int init_mem);
 		void clear();
@@ -310,7 +357,7 @@ class container : public container_base, public radius_mono {
 		 * \param[in] filename the name of the file to open and read
 		 *                     from. */
 		inline void import(const char* filename) {
-			FILE *fp=safe_fopen(filename,"r");
+			FILE *fp=safe_fopen(filename,"rb");
 			import(fp);
 			fclose(fp);
 		}
@@ -324,21 +371,21 @@ class container : public container_base, public radius_mono {
 		 * \param[in] filename the name of the file to open and read
 		 *                     from. */
 		inline void import(particle_order &vo,const char* filename) {
-			FILE *fp=safe_fopen(filename,"r");
+			FILE *fp=safe_fopen(filename,"rb");
 			import(vo,fp);
 			fclose(fp);
 		}
 		void compute_all_cells();
 		double sum_cell_volumes();
+		void compute_all_cells_parallel();
+		double sum_cell_volumes_parallel();
 		/** Dumps particle IDs and positions to a file.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles(c_loop &vl,FILE *fp) {
-			double *pp;
 			if(vl.start()) do {
-				pp=p[vl.ijk]+3*vl.q;
-				fprintf(fp,"%d %g %g %g\n",id[vl.ijk][vl.q],*pp,pp[1],pp[2]);
+				fprintf(fp,"%d %g %g %g\n",id[vl.ijk][vl.q],pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2));
 			} while(vl.inc());
 		}
 		/** Dumps all of the particle IDs and positions to a file.
@@ -359,11 +406,9 @@ class container : public container_base, public radius_mono {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles_pov(c_loop &vl,FILE *fp) {
-			double *pp;
 			if(vl.start()) do {
-				pp=p[vl.ijk]+3*vl.q;
 				fprintf(fp,"// id %d\nsphere{<%g,%g,%g>,s}\n",
-						id[vl.ijk][vl.q],*pp,pp[1],pp[2]);
+						id[vl.ijk][vl.q],pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2));
 			} while(vl.inc());
 		}
 		/** Dumps all particle positions in POV-Ray format.
@@ -385,10 +430,9 @@ class container : public container_base, public radius_mono {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_gnuplot(c_loop &vl,FILE *fp) {
-			voronoicell c;double *pp;
+			voronoicell c;
 			if(vl.start()) do if(compute_cell(c,vl)) {
-				pp=p[vl.ijk]+ps*vl.q;
-				c.draw_gnuplot(*pp,pp[1],pp[2],fp);
+				c.draw_gnuplot(pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2),fp);
 			} while(vl.inc());
 		}
 		/** Computes all Voronoi cells and saves the output in gnuplot
@@ -406,17 +450,26 @@ class container : public container_base, public radius_mono {
 			draw_cells_gnuplot(fp);
 			fclose(fp);
 		}
+		void draw_cells_gnuplot_parallel(FILE *fp=stdout);
+		/** Computes all Voronoi cells using multiple threads and saves
+		 * the output in gnuplot format, identical to that of
+		 * draw_cells_gnuplot.
+		 * \param[in] filename the name of the file to write to. */
+		inline void draw_cells_gnuplot_parallel(const char *filename) {
+			FILE *fp=safe_fopen(filename,"w");
+			draw_cells_gnuplot_parallel(fp);
+			fclose(fp);
+		}
 		/** Computes Voronoi cells and saves the output in POV-Ray
 		 * format.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_pov(c_loop &vl,FILE *fp) {
-			voronoicell c;double *pp;
+			voronoicell c;
 			if(vl.start()) do if(compute_cell(c,vl)) {
 				fprintf(fp,"// cell %d\n",id[vl.ijk][vl.q]);
-				pp=p[vl.ijk]+ps*vl.q;
-				c.draw_pov(*pp,pp[1],pp[2],fp);
+				c.draw_pov(pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2),fp);
 			} while(vl.inc());
 		}
 		/** Computes all Voronoi cells and saves the output in POV-Ray
@@ -441,23 +494,27 @@ class container : public container_base, public radius_mono {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void print_custom(c_loop &vl,const char *format,FILE *fp) {
-			int ijk,q;double *pp;
+			int ijk,q;
+			custom_format cf(format);
+			output_buffer ob(fp);
 			if(contains_neighbor(format)) {
 				voronoicell_neighbor c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
+					ijk=vl.ijk;q=vl.q;
+					c.output_custom(cf,id[ijk][q],pc(ijk,q,0),pc(ijk,q,1),pc(ijk,q,2),default_radius,ob);
 				} while(vl.inc());
 			} else {
 				voronoicell c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
+					ijk=vl.ijk;q=vl.q;
+					c.output_custom(cf,id[ijk][q],pc(ijk,q,0),pc(ijk,q,1),pc(ijk,q,2),default_radius,ob);
 				} while(vl.inc());
 			}
 		}
 		void print_custom(const char *format,FILE *fp=stdout);
 		void print_custom(const char *format,const char *filename);
+		void print_custom_parallel(const char *format,FILE *fp=stdout);
+		void print_custom_parallel(const char *format,const char *filename);
 		bool find_voronoi_cell(double x,double y,double z,double &rx,double &ry,double &rz,int &pid);
 		/** Computes the Voronoi cell for a particle currently being
 		 * referenced by a loop class.
@@ -486,6 +543,86 @@ class container : public container_base, public radius_mono {
 			int k=ijk/nxy,ijkt=ijk-nxy*k,j=ijkt/nx,i=ijkt-j*nx;
 			return vc.compute_cell(c,ijk,q,i,j,k);
 		}
+		/** Computes the Voronoi cell for given particle, first cutting
+		 * it by a list of seed particles, such as its neighbors from an
+		 * earlier computation. Good seeds let the search for the other
+		 * cutting particles stop after very few blocks; the computed
+		 * cell doesn't depend on them.
+		 * \param[out] c a Voronoi cell class in which to store the
+		 * 		 computed cell.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block.
+		 * \param[in] (sijk,sq) arrays of the blocks and indices within
+		 *		       the blocks of the seed particles.
+		 * \param[in] n the number of seed particles.
+		 * \return True if the cell was computed. If the cell cannot be
+		 * computed, if it is removed entirely by a wall or boundary
+		 * condition, then the routine returns false. */
+		template<class v_cell>
+		inline bool compute_cell_seeded(v_cell &c,int ijk,int q,const int *sijk,const int *sq,int n) {
+			int k=ijk/nxy,ijkt=ijk-nxy*k,j=ijkt/nx,i=ijkt-j*nx;
+			return vc.compute_cell_seeded(c,ijk,q,i,j,k,sijk,sq,n);
+		}
+		/** Computes the Voronoi cell for a particle currently being
+		 * referenced by a loop class, using a separate computation
+		 * context so that several threads can compute cells at once.
+		 * \param[out] c a Voronoi cell class in which to store the
+		 * 		 computed cell.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] vcc the calling thread's computation context.
+		 * \return True if the cell was computed. If the cell cannot be
+		 * computed, if it is removed entirely by a wall or boundary
+		 * condition, then the routine returns false. */
+		template<class v_cell,class c_loop>
+		inline bool compute_cell(v_cell &c,c_loop &vl,voro_compute_context<container> &vcc) {
+			return vcc.compute_cell(c,vl.ijk,vl.q,vl.i,vl.j,vl.k);
+		}
+		/** Computes the Voronoi cell for given particle, using a
+		 * separate computation context so that several threads can
+		 * compute cells at once.
+		 * \param[out] c a Voronoi cell class in which to store the
+		 * 		 computed cell.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block.
+		 * \param[in] vcc the calling thread's computation context.
+		 * \return True if the cell was computed. If the cell cannot be
+		 * computed, if it is removed entirely by a wall or boundary
+		 * condition, then the routine returns false. */
+		template<class v_cell>
+		inline bool compute_cell(v_cell &c,int ijk,int q,voro_compute_context<container> &vcc) {
+			int k=ijk/nxy,ijkt=ijk-nxy*k,j=ijkt/nx,i=ijkt-j*nx;
+			return vcc.compute_cell(c,ijk,q,i,j,k);
+		}
+		/** Computes the Voronoi cell for a given particle by cutting it
+		 * with the planes of a list of other particles only, rather
+		 * than searching the blocks around it. The result is the
+		 * Voronoi cell whenever the list includes all of the cell's
+		 * neighbors, which callers can often vouch for when updating a
+		 * cell after a small change to the particles around it.
+		 * Periodic images are not considered, so this should only be
+		 * used for non-periodic containers.
+		 * \param[out] c a Voronoi cell class in which to store the
+		 * 		 computed cell.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block.
+		 * \param[in] (cijk,cq) arrays of the blocks and indices within
+		 *		       the blocks of the particles to cut with.
+		 * \param[in] n the number of particles to cut with.
+		 * \return True if the cell was computed, false if it was
+		 * removed entirely by a wall or a plane cut. */
+		template<class v_cell>
+		bool compute_cell_from(v_cell &c,int ijk,int q,const int *cijk,const int *cq,int n) {
+			double x=pc(ijk,q,0),y=pc(ijk,q,1),z=pc(ijk,q,2),x1,y1,z1;
+			c.init(ax-x,bx-x,ay-y,by-y,az-z,bz-z);
+			if(!apply_walls(c,x,y,z)) return false;
+			for(int l=0;l<n;l++) {
+				x1=pc(cijk[l],cq[l],0)-x;
+				y1=pc(cijk[l],cq[l],1)-y;
+				z1=pc(cijk[l],cq[l],2)-z;
+				if(!c.nplane(x1,y1,z1,x1*x1+y1*y1+z1*z1,id[cijk[l]][cq[l]])) return false;
+			}
+			return true;
+		}
         inline bool valid_coords(int ijk, int q) {
             return (q>=0 && ijk >= 0 && ijk < nxyz && co[ijk] >= 0 && q < co[ijk]);
         }
@@ -495,8 +632,7 @@ class container : public container_base, public radius_mono {
             if (v) {
                 std::cout << "co[ijk]=" << co[ijk] << "; ";
                 for (int ii=0; ii<co[ijk]; ii++) {
-                    double *pp=p[ijk]+ii*3;
-                    std::cout << std::setprecision(17) << "(" << pp[0] << "," << pp[1] << "," << pp[2] << ") ";
+                    std::cout << std::setprecision(17) << "(" << pc(ijk,ii,0) << "," << pc(ijk,ii,1) << "," << pc(ijk,ii,2) << ") ";
                 }
             }
             std::cout << std::endl;
@@ -513,8 +649,7 @@ class container : public container_base, public radius_mono {
 		inline bool compute_ghost_cell(v_cell &c,double x,double y,double z) {
 			int ijk;
 			if(put_locate_block(ijk,x,y,z)) {
-				double *pp=p[ijk]+3*co[ijk]++;
-				*(pp++)=x;*(pp++)=y;*pp=z;
+				put_coords(ijk,co[ijk]++,x,y,z);
 				bool q=compute_cell(c,ijk,co[ijk]-1);
 				co[ijk]--;
 				return q;
@@ -524,6 +659,7 @@ class container : public container_base, public radius_mono {
 	private:
 		voro_compute<container> vc;
 		friend class voro_compute<container>;
+		friend class voro_compute_context<container>;
 };
 
 /** \brief Extension of the container_base class for computing radical Voronoi
@@ -534,6 +670,9 @@ class container : public container_base, public radius_mono {
  * the particle radii. */
 class container_poly : public container_base, public radius_poly {
 	public:
+		/** The radius option class, which voro_compute keeps its own
+		 * copy of during a cell computation. */
+		typedef radius_poly r_option;
 		container_poly(double ax_,double bx_,double ay_,double by_,double az_,double bz_,
 				int nx_,int ny_,int nz_,bool xperiodic_,bool yperiodic_,bool zperiodic_,int init_mem);
 		void clear();
@@ -549,7 +688,7 @@ class container_poly : public container_base, public radius_poly {
 		 * \param[in] filename the name of the file to open and read
 		 *                     from. */
 		inline void import(const char* filename) {
-			FILE *fp=safe_fopen(filename,"r");
+			FILE *fp=safe_fopen(filename,"rb");
 			import(fp);
 			fclose(fp);
 		}
@@ -563,21 +702,21 @@ class container_poly : public container_base, public radius_poly {
 		 * \param[in] filename the name of the file to open and read
 		 *                     from. */
 		inline void import(particle_order &vo,const char* filename) {
-			FILE *fp=safe_fopen(filename,"r");
+			FILE *fp=safe_fopen(filename,"rb");
 			import(vo,fp);
 			fclose(fp);
 		}
 		void compute_all_cells();
 		double sum_cell_volumes();
+		void compute_all_cells_parallel();
+		double sum_cell_volumes_parallel();
 		/** Dumps particle IDs, positions and radii to a file.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles(c_loop &vl,FILE *fp) {
-			double *pp;
 			if(vl.start()) do {
-				pp=p[vl.ijk]+4*vl.q;
-				fprintf(fp,"%d %g %g %g %g\n",id[vl.ijk][vl.q],*pp,pp[1],pp[2],pp[3]);
+				fprintf(fp,"%d %g %g %g %g\n",id[vl.ijk][vl.q],pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2),pc(vl.ijk,vl.q,3));
 			} while(vl.inc());
 		}
 		/** Dumps all of the particle IDs, positions and radii to a
@@ -600,11 +739,9 @@ class container_poly : public container_base, public radius_poly {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles_pov(c_loop &vl,FILE *fp) {
-			double *pp;
 			if(vl.start()) do {
-				pp=p[vl.ijk]+4*vl.q;
 				fprintf(fp,"// id %d\nsphere{<%g,%g,%g>,%g}\n",
-						id[vl.ijk][vl.q],*pp,pp[1],pp[2],pp[3]);
+						id[vl.ijk][vl.q],pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2),pc(vl.ijk,vl.q,3));
 			} while(vl.inc());
 		}
 		/** Dumps all the particle positions in POV-Ray format.
@@ -626,10 +763,9 @@ class container_poly : public container_base, public radius_poly {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_gnuplot(c_loop &vl,FILE *fp) {
-			voronoicell c;double *pp;
+			voronoicell c;
 			if(vl.start()) do if(compute_cell(c,vl)) {
-				pp=p[vl.ijk]+ps*vl.q;
-				c.draw_gnuplot(*pp,pp[1],pp[2],fp);
+				c.draw_gnuplot(pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2),fp);
 			} while(vl.inc());
 		}
 		/** Compute all Voronoi cells and saves the output in gnuplot
@@ -647,17 +783,26 @@ class container_poly : public container_base, public radius_poly {
 			draw_cells_gnuplot(fp);
 			fclose(fp);
 		}
+		void draw_cells_gnuplot_parallel(FILE *fp=stdout);
+		/** Computes all Voronoi cells using multiple threads and saves
+		 * the output in gnuplot format, identical to that of
+		 * draw_cells_gnuplot.
+		 * \param[in] filename the name of the file to write to. */
+		inline void draw_cells_gnuplot_parallel(const char *filename) {
+			FILE *fp=safe_fopen(filename,"w");
+			draw_cells_gnuplot_parallel(fp);
+			fclose(fp);
+		}
 		/** Computes Voronoi cells and saves the output in POV-Ray
 		 * format.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_pov(c_loop &vl,FILE *fp) {
-			voronoicell c;double *pp;
+			voronoicell c;
 			if(vl.start()) do if(compute_cell(c,vl)) {
 				fprintf(fp,"// cell %d\n",id[vl.ijk][vl.q]);
-				pp=p[vl.ijk]+ps*vl.q;
-				c.draw_pov(*pp,pp[1],pp[2],fp);
+				c.draw_pov(pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2),fp);
 			} while(vl.inc());
 		}
 		/** Computes all Voronoi cells and saves the output in POV-Ray
@@ -682,18 +827,20 @@ class container_poly : public container_base, public radius_poly {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void print_custom(c_loop &vl,const char *format,FILE *fp) {
-			int ijk,q;double *pp;
+			int ijk,q;
+			custom_format cf(format);
+			output_buffer ob(fp);
 			if(contains_neighbor(format)) {
 				voronoicell_neighbor c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
+					ijk=vl.ijk;q=vl.q;
+					c.output_custom(cf,id[ijk][q],pc(ijk,q,0),pc(ijk,q,1),pc(ijk,q,2),pc(ijk,q,3),ob);
 				} while(vl.inc());
 			} else {
 				voronoicell c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
+					ijk=vl.ijk;q=vl.q;
+					c.output_custom(cf,id[ijk][q],pc(ijk,q,0),pc(ijk,q,1),pc(ijk,q,2),pc(ijk,q,3),ob);
 				} while(vl.inc());
 			}
 		}
@@ -722,6 +869,56 @@ class container_poly : public container_base, public radius_poly {
 			int k=ijk/nxy,ijkt=ijk-nxy*k,j=ijkt/nx,i=ijkt-j*nx;
 			return vc.compute_cell(c,ijk,q,i,j,k);
 		}
+		/** Computes the Voronoi cell for given particle, first cutting
+		 * it by a list of seed particles, such as its neighbors from an
+		 * earlier computation. Good seeds let the search for the other
+		 * cutting particles stop after very few blocks; the computed
+		 * cell doesn't depend on them.
+		 * \param[out] c a Voronoi cell class in which to store the
+		 * 		 computed cell.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block.
+		 * \param[in] (sijk,sq) arrays of the blocks and indices within
+		 *		       the blocks of the seed particles.
+		 * \param[in] n the number of seed particles.
+		 * \return True if the cell was computed. If the cell cannot be
+		 * computed, if it is removed entirely by a wall or boundary
+		 * condition, then the routine returns false. */
+		template<class v_cell>
+		inline bool compute_cell_seeded(v_cell &c,int ijk,int q,const int *sijk,const int *sq,int n) {
+			int k=ijk/nxy,ijkt=ijk-nxy*k,j=ijkt/nx,i=ijkt-j*nx;
+			return vc.compute_cell_seeded(c,ijk,q,i,j,k,sijk,sq,n);
+		}
+		/** Computes the Voronoi cell for a particle currently being
+		 * referenced by a loop class, using a separate computation
+		 * context so that several threads can compute cells at once.
+		 * \param[out] c a Voronoi cell class in which to store the
+		 * 		 computed cell.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] vcc the calling thread's computation context.
+		 * \return True if the cell was computed. If the cell cannot be
+		 * computed, if it is removed entirely by a wall or boundary
+		 * condition, then the routine returns false. */
+		template<class v_cell,class c_loop>
+		inline bool compute_cell(v_cell &c,c_loop &vl,voro_compute_context<container_poly> &vcc) {
+			return vcc.compute_cell(c,vl.ijk,vl.q,vl.i,vl.j,vl.k);
+		}
+		/** Computes the Voronoi cell for given particle, using a
+		 * separate computation context so that several threads can
+		 * compute cells at once.
+		 * \param[out] c a Voronoi cell class in which to store the
+		 * 		 computed cell.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block.
+		 * \param[in] vcc the calling thread's computation context.
+		 * \return True if the cell was computed. If the cell cannot be
+		 * computed, if it is removed entirely by a wall or boundary
+		 * condition, then the routine returns false. */
+		template<class v_cell>
+		inline bool compute_cell(v_cell &c,int ijk,int q,voro_compute_context<container_poly> &vcc) {
+			int k=ijk/nxy,ijkt=ijk-nxy*k,j=ijkt/nx,i=ijkt-j*nx;
+			return vcc.compute_cell(c,ijk,q,i,j,k);
+		}
 		/** Computes the Voronoi cell for a ghost particle at a given
 		 * location.
 		 * \param[out] c a Voronoi cell class in which to store the
@@ -735,8 +932,9 @@ class container_poly : public container_base, public radius_poly {
 		inline bool compute_ghost_cell(v_cell &c,double x,double y,double z,double r) {
 			int ijk;
 			if(put_locate_block(ijk,x,y,z)) {
-				double *pp=p[ijk]+4*co[ijk]++,tm=max_radius;
-				*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
+				double tm=max_radius;
+				pc(ijk,co[ijk],3)=r;
+				put_coords(ijk,co[ijk]++,x,y,z);
 				if(r>max_radius) max_radius=r;
 				bool q=compute_cell(c,ijk,co[ijk]-1);
 				co[ijk]--;max_radius=tm;
@@ -746,10 +944,13 @@ class container_poly : public container_base, public radius_poly {
 		}
 		void print_custom(const char *format,FILE *fp=stdout);
 		void print_custom(const char *format,const char *filename);
+		void print_custom_parallel(const char *format,FILE *fp=stdout);
+		void print_custom_parallel(const char *format,const char *filename);
 		bool find_voronoi_cell(double x,double y,double z,double &rx,double &ry,double &rz,int &pid);
 	private:
 		voro_compute<container_poly> vc;
 		friend class voro_compute<container_poly>;
+		friend class voro_compute_context<container_poly>;
 };
 
 }
@@ -85,7 +85,7 @@ container_periodic::container_periodic(double bx_,double bxy_,double by_,double
 container_periodic_poly::container_periodic_poly(double bx_,double bxy_,double by_,double bxz_,double byz_,double bz_,
 	int nx_,int ny_,int nz_,int init_mem_)
 	: container_periodic_base(bx_,bxy_,by_,bxz_,byz_,bz_,nx_,ny_,nz_,init_mem_,4),
-	vc(*this,2*nx_+1,2*ey+1,2*ez+1) {ppr=p;}
+	vc(*this,2*nx_+1,2*ey+1,2*ez+1) {ppr=p;pmem=mem;}
 
 /** Put a particle into the correct region of the container.
  * \param[in] n the numerical ID of the inserted particle.
@@ -94,8 +94,7 @@ void container_periodic::put(int n,double x,double y,double z) {
 	int ijk;
 	put_locate_block(ijk,x,y,z);
 	id[ijk][co[ijk]]=n;
-	double *pp=p[ijk]+3*co[ijk]++;
-	*(pp++)=x;*(pp++)=y;*pp=z;
+	put_coords(ijk,co[ijk]++,x,y,z);
 }
 
 /** Put a particle into the correct region of the container.
@@ -106,8 +105,8 @@ void container_periodic_poly::put(int n,double x,double y,double z,double r) {
 	int ijk;
 	put_locate_block(ijk,x,y,z);
 	id[ijk][co[ijk]]=n;
-	double *pp=p[ijk]+4*co[ijk]++;
-	*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
+	pc(ijk,co[ijk],3)=r;
+	put_coords(ijk,co[ijk]++,x,y,z);
 	if(max_radius<r) max_radius=r;
 }
 
@@ -121,8 +120,7 @@ void container_periodic::put(int n,double x,double y,double z,int &ai,int &aj,in
 	int ijk;
 	put_locate_block(ijk,x,y,z,ai,aj,ak);
 	id[ijk][co[ijk]]=n;
-	double *pp=p[ijk]+3*co[ijk]++;
-	*(pp++)=x;*(pp++)=y;*pp=z;
+	put_coords(ijk,co[ijk]++,x,y,z);
 }
 
 /** Put a particle into the correct region of the container.
@@ -136,8 +134,8 @@ void container_periodic_poly::put(int n,double x,double y,double z,double r,int
 	int ijk;
 	put_locate_block(ijk,x,y,z,ai,aj,ak);
 	id[ijk][co[ijk]]=n;
-	double *pp=p[ijk]+4*co[ijk]++;
-	*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
+	pc(ijk,co[ijk],3)=r;
+	put_coords(ijk,co[ijk]++,x,y,z);
 	if(max_radius<r) max_radius=r;
 }
 
@@ -151,8 +149,7 @@ void container_periodic::put(particle_order &vo,int n,double x,double y,double z
 	put_locate_block(ijk,x,y,z);
 	id[ijk][co[ijk]]=n;
 	vo.add(ijk,co[ijk]);
-	double *pp=p[ijk]+3*co[ijk]++;
-	*(pp++)=x;*(pp++)=y;*pp=z;
+	put_coords(ijk,co[ijk]++,x,y,z);
 }
 
 /** Put a particle into the correct region of the container, also recording
@@ -166,8 +163,8 @@ void container_periodic_poly::put(particle_order &vo,int n,double x,double y,dou
 	put_locate_block(ijk,x,y,z);
 	id[ijk][co[ijk]]=n;
 	vo.add(ijk,co[ijk]);
-	double *pp=p[ijk]+4*co[ijk]++;
-	*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
+	pc(ijk,co[ijk],3)=r;
+	put_coords(ijk,co[ijk]++,x,y,z);
 	if(max_radius<r) max_radius=r;
 }
 
@@ -309,9 +306,9 @@ bool container_periodic::find_voronoi_cell(double x,double y,double z,double &rx
 		// Assemble the position vector of the particle to be returned,
 		// applying a periodic remapping if necessary
 		ci+=w.di;if(ci<0||ci>=nx) ai+=step_div(ci,nx);
-		rx=p[w.ijk][3*w.l]+ak*bxz+aj*bxy+ai*bx;
-		ry=p[w.ijk][3*w.l+1]+ak*byz+aj*by;
-		rz=p[w.ijk][3*w.l+2]+ak*bz;
+		rx=pc(w.ijk,w.l,0)+ak*bxz+aj*bxy+ai*bx;
+		ry=pc(w.ijk,w.l,1)+ak*byz+aj*by;
+		rz=pc(w.ijk,w.l,2)+ak*bz;
 		pid=id[w.ijk][w.l];
 		return true;
 	}
@@ -343,9 +340,9 @@ bool container_periodic_poly::find_voronoi_cell(double x,double y,double z,doubl
 		// Assemble the position vector of the particle to be returned,
 		// applying a periodic remapping if necessary
 		ci+=w.di;if(ci<0||ci>=nx) ai+=step_div(ci,nx);
-		rx=p[w.ijk][4*w.l]+ak*bxz+aj*bxy+ai*bx;
-		ry=p[w.ijk][4*w.l+1]+ak*byz+aj*by;
-		rz=p[w.ijk][4*w.l+2]+ak*bz;
+		rx=pc(w.ijk,w.l,0)+ak*bxz+aj*bxy+ai*bx;
+		ry=pc(w.ijk,w.l,1)+ak*byz+aj*by;
+		rz=pc(w.ijk,w.l,2)+ak*bz;
 		pid=id[w.ijk][w.l];
 		return true;
 	}
@@ -378,7 +375,7 @@ void container_periodic_base::add_particle_memory(int i) {
 	int *idp=new int[nmem];
 	for(l=0;l<co[i];l++) idp[l]=id[i][l];
 	double *pp=new double[ps*nmem];
-	for(l=0;l<ps*co[i];l++) pp[l]=p[i][l];
+	particle_layout::grow(pp,p[i],ps,co[i],mem[i],nmem);
 
 	// Update pointers and delete old arrays
 	mem[i]=nmem;
@@ -392,10 +389,10 @@ void container_periodic_base::add_particle_memory(int i) {
  * causes a fatal error.
  * \param[in] fp the file handle to read from. */
 void container_periodic::import(FILE *fp) {
-	int i,j;
-	double x,y,z;
-	while((j=fscanf(fp,"%d %lg %lg %lg",&i,&x,&y,&z))==4) put(i,x,y,z);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_reader pr(fp,3);
+	int i;
+	double v[3];
+	while(pr.next(i,v)) put(i,v[0],v[1],v[2]);
 }
 
 /** Import a list of particles from an open file stream, also storing the order
@@ -405,10 +402,10 @@ void container_periodic::import(FILE *fp) {
  * \param[in,out] vo a reference to an ordering class to use.
  * \param[in] fp the file handle to read from. */
 void container_periodic::import(particle_order &vo,FILE *fp) {
-	int i,j;
-	double x,y,z;
-	while((j=fscanf(fp,"%d %lg %lg %lg",&i,&x,&y,&z))==4) put(vo,i,x,y,z);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_reader pr(fp,3);
+	int i;
+	double v[3];
+	while(pr.next(i,v)) put(vo,i,v[0],v[1],v[2]);
 }
 
 /** Import a list of particles from an open file stream into the container.
@@ -417,10 +414,10 @@ void container_periodic::import(particle_order &vo,FILE *fp) {
  * routine causes a fatal error.
  * \param[in] fp the file handle to read from. */
 void container_periodic_poly::import(FILE *fp) {
-	int i,j;
-	double x,y,z,r;
-	while((j=fscanf(fp,"%d %lg %lg %lg %lg",&i,&x,&y,&z,&r))==5) put(i,x,y,z,r);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_reader pr(fp,4);
+	int i;
+	double v[4];
+	while(pr.next(i,v)) put(i,v[0],v[1],v[2],v[3]);
 }
 
 /** Import a list of particles from an open file stream, also storing the order
@@ -430,10 +427,10 @@ void container_periodic_poly::import(FILE *fp) {
  * \param[in,out] vo a reference to an ordering class to use.
  * \param[in] fp the file handle to read from. */
 void container_periodic_poly::import(particle_order &vo,FILE *fp) {
-	int i,j;
-	double x,y,z,r;
-	while((j=fscanf(fp,"%d %lg %lg %lg %lg",&i,&x,&y,&z,&r))==5) put(vo,i,x,y,z,r);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_reader pr(fp,4);
+	int i;
+	double v[4];
+	while(pr.next(i,v)) put(vo,i,v[0],v[1],v[2],v[3]);
 }
 
 /** Outputs the a list of all the container regions along with the number of
@@ -549,7 +546,7 @@ void container_periodic_base::create_all_images() {
  * This is useful for diagnosing problems with periodic image computation. */
 void container_periodic_base::check_compartmentalized() {
 	int c,l,i,j,k;
-	double mix,miy,miz,max,may,maz,*pp;
+	double mix,miy,miz,max,may,maz,x,y,z;
 	for(k=l=0;k<oz;k++) for(j=0;j<oy;j++) for(i=0;i<nx;i++,l++) if(mem[l]>0) {
 
 		// Compute the block's bounds, adding in a small tolerance
@@ -559,9 +556,12 @@ void container_periodic_base::check_compartmentalized() {
 
 		// Print entries for any particles that lie outside the block's
 		// bounds
-		for(pp=p[l],c=0;c<co[l];c++,pp+=ps) if(*pp<mix||*pp>max||pp[1]<miy||pp[1]>may||pp[2]<miz||pp[2]>maz)
-			printf("%d %d %d %d %f %f %f %f %f %f %f %f %f\n",
-			       id[l][c],i,j,k,*pp,pp[1],pp[2],mix,max,miy,may,miz,maz);
+		for(c=0;c<co[l];c++) {
+			x=pc(l,c,0);y=pc(l,c,1);z=pc(l,c,2);
+			if(x<mix||x>max||y<miy||y>may||z<miz||z>maz)
+				printf("%d %d %d %d %f %f %f %f %f %f %f %f %f\n",
+				       id[l][c],i,j,k,x,y,z,mix,max,miy,may,miz,maz);
+		}
 	}
 }
 
@@ -587,7 +587,7 @@ void container_periodic_base::create_side_image(int di,int dj,int dk) {
 		}
 		img[odijk]|=2;
 		for(l=0;l<co[fijk];l++) {
-			if(p[fijk][ps*l]>switchx) put_image(dijk,fijk,l,dis,by*ima,0);
+			if(pc(fijk,l,0)>switchx) put_image(dijk,fijk,l,dis,by*ima,0);
 			else put_image(odijk,fijk,l,adis,by*ima,0);
 		}
 	}
@@ -606,7 +606,7 @@ void container_periodic_base::create_side_image(int di,int dj,int dk) {
 		}
 		img[odijk]|=1;
 		for(l=0;l<co[fijk];l++) {
-			if(p[fijk][ps*l]<switchx) put_image(dijk,fijk,l,dis,by*ima,0);
+			if(pc(fijk,l,0)<switchx) put_image(dijk,fijk,l,dis,by*ima,0);
 			else put_image(odijk,fijk,l,adis,by*ima,0);
 		}
 	}
@@ -648,12 +648,12 @@ void container_periodic_base::create_vertical_image(int di,int dj,int dk) {
 			img[dijk-nx]|=4;
 		}
 		for(l=0;l<co[fijk];l++) {
-			if(p[fijk][ps*l+1]>switchy) {
-				if(p[fijk][ps*l]>switchx) put_image(dijk,fijk,l,disx,disy,bz*ima);
+			if(pc(fijk,l,1)>switchy) {
+				if(pc(fijk,l,0)>switchx) put_image(dijk,fijk,l,disx,disy,bz*ima);
 				else put_image(dijkl,fijk,l,disxl,disy,bz*ima);
 			} else {
 				if(!y_exist) continue;
-				if(p[fijk][ps*l]>switchx) put_image(dijk-nx,fijk,l,disx,disy,bz*ima);
+				if(pc(fijk,l,0)>switchx) put_image(dijk-nx,fijk,l,disx,disy,bz*ima);
 				else put_image(dijkl-nx,fijk,l,disxl,disy,bz*ima);
 			}
 		}
@@ -672,12 +672,12 @@ void container_periodic_base::create_vertical_image(int di,int dj,int dk) {
 			img[dijk-nx]|=8;
 		}
 		for(l=0;l<co[fijk2];l++) {
-			if(p[fijk2][ps*l+1]>switchy) {
-				if(p[fijk2][ps*l]>switchx2) put_image(dijkr,fijk2,l,disxr2,disy,bz*ima);
+			if(pc(fijk2,l,1)>switchy) {
+				if(pc(fijk2,l,0)>switchx2) put_image(dijkr,fijk2,l,disxr2,disy,bz*ima);
 				else put_image(dijk,fijk2,l,disx2,disy,bz*ima);
 			} else {
 				if(!y_exist) continue;
-				if(p[fijk2][ps*l]>switchx2) put_image(dijkr-nx,fijk2,l,disxr2,disy,bz*ima);
+				if(pc(fijk2,l,0)>switchx2) put_image(dijkr-nx,fijk2,l,disxr2,disy,bz*ima);
 				else put_image(dijk-nx,fijk2,l,disx2,disy,bz*ima);
 			}
 		}
@@ -709,12 +709,12 @@ void container_periodic_base::create_vertical_image(int di,int dj,int dk) {
 			img[dijk+nx]|=1;
 		}
 		for(l=0;l<co[fijk];l++) {
-			if(p[fijk][ps*l+1]>switchy) {
+			if(pc(fijk,l,1)>switchy) {
 				if(!y_exist) continue;
-				if(p[fijk][ps*l]>switchx) put_image(dijk+nx,fijk,l,disx,disy,bz*ima);
+				if(pc(fijk,l,0)>switchx) put_image(dijk+nx,fijk,l,disx,disy,bz*ima);
 				else put_image(dijkl+nx,fijk,l,disxl,disy,bz*ima);
 			} else {
-				if(p[fijk][ps*l]>switchx) put_image(dijk,fijk,l,disx,disy,bz*ima);
+				if(pc(fijk,l,0)>switchx) put_image(dijk,fijk,l,disx,disy,bz*ima);
 				else put_image(dijkl,fijk,l,disxl,disy,bz*ima);
 			}
 		}
@@ -733,12 +733,12 @@ void container_periodic_base::create_vertical_image(int di,int dj,int dk) {
 			img[dijk+nx]|=2;
 		}
 		for(l=0;l<co[fijk2];l++) {
-			if(p[fijk2][ps*l+1]>switchy) {
+			if(pc(fijk2,l,1)>switchy) {
 				if(!y_exist) continue;
-				if(p[fijk2][ps*l]>switchx2) put_image(dijkr+nx,fijk2,l,disxr2,disy,bz*ima);
+				if(pc(fijk2,l,0)>switchx2) put_image(dijkr+nx,fijk2,l,disxr2,disy,bz*ima);
 				else put_image(dijk+nx,fijk2,l,disx2,disy,bz*ima);
 			} else {
-				if(p[fijk2][ps*l]>switchx2) put_image(dijkr,fijk2,l,disxr2,disy,bz*ima);
+				if(pc(fijk2,l,0)>switchx2) put_image(dijkr,fijk2,l,disxr2,disy,bz*ima);
 				else put_image(dijk,fijk2,l,disx2,disy,bz*ima);
 			}
 		}
@@ -757,11 +757,11 @@ void container_periodic_base::create_vertical_image(int di,int dj,int dk) {
  * \param[in] (dx,dy,dz) the displacement vector to add to the particle. */
 void container_periodic_base::put_image(int reg,int fijk,int l,double dx,double dy,double dz) {
 	if(co[reg]==mem[reg]) add_particle_memory(reg);
-	double *p1=p[reg]+ps*co[reg],*p2=p[fijk]+ps*l;
-	*(p1++)=*(p2++)+dx;
-	*(p1++)=*(p2++)+dy;
-	*p1=*p2+dz;
-	if(ps==4) *(++p1)=*(++p2);
+	int q=co[reg];
+	pc(reg,q,0)=pc(fijk,l,0)+dx;
+	pc(reg,q,1)=pc(fijk,l,1)+dy;
+	pc(reg,q,2)=pc(fijk,l,2)+dz;
+	if(ps==4) pc(reg,q,3)=pc(fijk,l,3);
 	id[reg][co[reg]++]=id[fijk][l];
 }
 
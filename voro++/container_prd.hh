@@ -21,6 +21,8 @@
 #include "v_compute.hh"
 #include "unitcell.hh"
 #include "rad_option.hh"
+#include "particle_layout.hh"
+#include "particle_reader.hh"
 
 namespace voro {
 
@@ -91,6 +93,21 @@ class container_periodic_base : public unitcell, public voro_base {
 		 * class container_poly, then this is set to 4, to also hold
 		 * the particle radii. */
 		const int ps;
+		/** Returns a reference to one coordinate of a particle, in the
+		 * layout set by the particle_layout storage policy.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] l the index of the particle within the block.
+		 * \param[in] c the coordinate (0 to 3 for x, y, z and r). */
+		inline double &pc(int ijk,int l,int c) {
+			return p[ijk][particle_layout::at(ps,mem[ijk],l,c)];
+		}
+		/** Stores the position of a particle within a block.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] l the index of the particle within the block.
+		 * \param[in] (x,y,z) the position vector of the particle. */
+		inline void put_coords(int ijk,int l,double x,double y,double z) {
+			pc(ijk,l,0)=x;pc(ijk,l,1)=y;pc(ijk,l,2)=z;
+		}
 		container_periodic_base(double bx_,double bxy_,double by_,double bxz_,double byz_,double bz_,
 				int nx_,int ny_,int nz_,int init_mem_,int ps);
 		~container_periodic_base();
@@ -99,7 +116,7 @@ class container_periodic_base : public unitcell, public voro_base {
 		inline void print_all_particles() {
 			int ijk,q;
 			for(ijk=0;ijk<oxyz;ijk++) for(q=0;q<co[ijk];q++)
-				printf("%d %g %g %g\n",id[ijk][q],p[ijk][ps*q],p[ijk][ps*q+1],p[ijk][ps*q+2]);
+				printf("%d %g %g %g\n",id[ijk][q],pc(ijk,q,0),pc(ijk,q,1),pc(ijk,q,2));
 		}
 		void region_count();
 		/** Initializes the Voronoi cell prior to a compute_cell
@@ -123,8 +140,7 @@ class container_periodic_base : public unitcell, public voro_base {
 		template<class v_cell>
 		inline bool initialize_voronoicell(v_cell &c,int ijk,int q,int ci,int cj,int ck,int &i,int &j,int &k,double &x,double &y,double &z,int &disp) {
 			c=unit_voro;
-			double *pp=p[ijk]+ps*q;
-			x=*(pp++);y=*(pp++);z=*pp;
+			x=pc(ijk,q,0);y=pc(ijk,q,1);z=pc(ijk,q,2);
 			i=nx;j=ey;k=ez;
 			return true;
 		}
@@ -211,6 +227,9 @@ class container_periodic_base : public unitcell, public voro_base {
  * dependence on particle radii. */
 class container_periodic : public container_periodic_base, public radius_mono {
 	public:
+		/** The radius option class, which voro_compute keeps its own
+		 * copy of during a cell computation. */
+		typedef radius_mono r_option;
 		container_periodic(double bx_,double bxy_,double by_,double bxz_,double byz_,double bz_,
 				int nx_,int ny_,int nz_,int init_mem_);
 		void clear();
@@ -227,7 +246,7 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		 * \param[in] filename the name of the file to open and read
 		 *                     from. */
 		inline void import(const char* filename) {
-			FILE *fp=safe_fopen(filename,"r");
+			FILE *fp=safe_fopen(filename,"rb");
 			import(fp);
 			fclose(fp);
 		}
@@ -241,7 +260,7 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		 * \param[in] filename the name of the file to open and read
 		 *                     from. */
 		inline void import(particle_order &vo,const char* filename) {
-			FILE *fp=safe_fopen(filename,"r");
+			FILE *fp=safe_fopen(filename,"rb");
 			import(vo,fp);
 			fclose(fp);
 		}
@@ -252,10 +271,8 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles(c_loop &vl,FILE *fp) {
-			double *pp;
 			if(vl.start()) do {
-				pp=p[vl.ijk]+3*vl.q;
-				fprintf(fp,"%d %g %g %g\n",id[vl.ijk][vl.q],*pp,pp[1],pp[2]);
+				fprintf(fp,"%d %g %g %g\n",id[vl.ijk][vl.q],pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2));
 			} while(vl.inc());
 		}
 		/** Dumps all of the particle IDs and positions to a file.
@@ -276,11 +293,9 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles_pov(c_loop &vl,FILE *fp) {
-			double *pp;
 			if(vl.start()) do {
-				pp=p[vl.ijk]+3*vl.q;
 				fprintf(fp,"// id %d\nsphere{<%g,%g,%g>,s}\n",
-						id[vl.ijk][vl.q],*pp,pp[1],pp[2]);
+						id[vl.ijk][vl.q],pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2));
 			} while(vl.inc());
 		}
 		/** Dumps all particle positions in POV-Ray format.
@@ -302,10 +317,9 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_gnuplot(c_loop &vl,FILE *fp) {
-			voronoicell c;double *pp;
+			voronoicell c;
 			if(vl.start()) do if(compute_cell(c,vl)) {
-				pp=p[vl.ijk]+ps*vl.q;
-				c.draw_gnuplot(*pp,pp[1],pp[2],fp);
+				c.draw_gnuplot(pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2),fp);
 			} while(vl.inc());
 		}
 		/** Computes all Voronoi cells and saves the output in gnuplot
@@ -329,11 +343,10 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_pov(c_loop &vl,FILE *fp) {
-			voronoicell c;double *pp;
+			voronoicell c;
 			if(vl.start()) do if(compute_cell(c,vl)) {
 				fprintf(fp,"// cell %d\n",id[vl.ijk][vl.q]);
-				pp=p[vl.ijk]+ps*vl.q;
-				c.draw_pov(*pp,pp[1],pp[2],fp);
+				c.draw_pov(pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2),fp);
 			} while(vl.inc());
 		}
 		/** Computes all Voronoi cells and saves the output in POV-Ray
@@ -358,18 +371,20 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void print_custom(c_loop &vl,const char *format,FILE *fp) {
-			int ijk,q;double *pp;
+			int ijk,q;
+			custom_format cf(format);
+			output_buffer ob(fp);
 			if(contains_neighbor(format)) {
 				voronoicell_neighbor c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
+					ijk=vl.ijk;q=vl.q;
+					c.output_custom(cf,id[ijk][q],pc(ijk,q,0),pc(ijk,q,1),pc(ijk,q,2),default_radius,ob);
 				} while(vl.inc());
 			} else {
 				voronoicell c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
+					ijk=vl.ijk;q=vl.q;
+					c.output_custom(cf,id[ijk][q],pc(ijk,q,0),pc(ijk,q,1),pc(ijk,q,2),default_radius,ob);
 				} while(vl.inc());
 			}
 		}
@@ -413,8 +428,7 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		inline bool compute_ghost_cell(v_cell &c,double x,double y,double z) {
 			int ijk;
 			put_locate_block(ijk,x,y,z);
-			double *pp=p[ijk]+3*co[ijk]++;
-			*(pp++)=x;*(pp++)=y;*(pp++)=z;
+			put_coords(ijk,co[ijk]++,x,y,z);
 			bool q=compute_cell(c,ijk,co[ijk]-1);
 			co[ijk]--;
 			return q;
@@ -432,6 +446,9 @@ class container_periodic : public container_periodic_base, public radius_mono {
  * on the particle radii. */
 class container_periodic_poly : public container_periodic_base, public radius_poly {
 	public:
+		/** The radius option class, which voro_compute keeps its own
+		 * copy of during a cell computation. */
+		typedef radius_poly r_option;
 		container_periodic_poly(double bx_,double bxy_,double by_,double bxz_,double byz_,double bz_,
 				int nx_,int ny_,int nz_,int init_mem_);
 		void clear();
@@ -448,7 +465,7 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		 * \param[in] filename the name of the file to open and read
 		 *                     from. */
 		inline void import(const char* filename) {
-			FILE *fp=safe_fopen(filename,"r");
+			FILE *fp=safe_fopen(filename,"rb");
 			import(fp);
 			fclose(fp);
 		}
@@ -462,7 +479,7 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		 * \param[in] filename the name of the file to open and read
 		 *                     from. */
 		inline void import(particle_order &vo,const char* filename) {
-			FILE *fp=safe_fopen(filename,"r");
+			FILE *fp=safe_fopen(filename,"rb");
 			import(vo,fp);
 			fclose(fp);
 		}
@@ -473,10 +490,8 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles(c_loop &vl,FILE *fp) {
-			double *pp;
 			if(vl.start()) do {
-				pp=p[vl.ijk]+4*vl.q;
-				fprintf(fp,"%d %g %g %g %g\n",id[vl.ijk][vl.q],*pp,pp[1],pp[2],pp[3]);
+				fprintf(fp,"%d %g %g %g %g\n",id[vl.ijk][vl.q],pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2),pc(vl.ijk,vl.q,3));
 			} while(vl.inc());
 		}
 		/** Dumps all of the particle IDs, positions and radii to a
@@ -499,11 +514,9 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles_pov(c_loop &vl,FILE *fp) {
-			double *pp;
 			if(vl.start()) do {
-				pp=p[vl.ijk]+4*vl.q;
 				fprintf(fp,"// id %d\nsphere{<%g,%g,%g>,%g}\n",
-						id[vl.ijk][vl.q],*pp,pp[1],pp[2],pp[3]);
+						id[vl.ijk][vl.q],pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2),pc(vl.ijk,vl.q,3));
 			} while(vl.inc());
 		}
 		/** Dumps all the particle positions in POV-Ray format.
@@ -525,10 +538,9 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_gnuplot(c_loop &vl,FILE *fp) {
-			voronoicell c;double *pp;
+			voronoicell c;
 			if(vl.start()) do if(compute_cell(c,vl)) {
-				pp=p[vl.ijk]+ps*vl.q;
-				c.draw_gnuplot(*pp,pp[1],pp[2],fp);
+				c.draw_gnuplot(pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2),fp);
 			} while(vl.inc());
 		}
 		/** Compute all Voronoi cells and saves the output in gnuplot
@@ -552,11 +564,10 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_pov(c_loop &vl,FILE *fp) {
-			voronoicell c;double *pp;
+			voronoicell c;
 			if(vl.start()) do if(compute_cell(c,vl)) {
 				fprintf(fp,"// cell %d\n",id[vl.ijk][vl.q]);
-				pp=p[vl.ijk]+ps*vl.q;
-				c.draw_pov(*pp,pp[1],pp[2],fp);
+				c.draw_pov(pc(vl.ijk,vl.q,0),pc(vl.ijk,vl.q,1),pc(vl.ijk,vl.q,2),fp);
 			} while(vl.inc());
 		}
 		/** Computes all Voronoi cells and saves the output in POV-Ray
@@ -581,18 +592,20 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void print_custom(c_loop &vl,const char *format,FILE *fp) {
-			int ijk,q;double *pp;
+			int ijk,q;
+			custom_format cf(format);
+			output_buffer ob(fp);
 			if(contains_neighbor(format)) {
 				voronoicell_neighbor c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
+					ijk=vl.ijk;q=vl.q;
+					c.output_custom(cf,id[ijk][q],pc(ijk,q,0),pc(ijk,q,1),pc(ijk,q,2),pc(ijk,q,3),ob);
 				} while(vl.inc());
 			} else {
 				voronoicell c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
+					ijk=vl.ijk;q=vl.q;
+					c.output_custom(cf,id[ijk][q],pc(ijk,q,0),pc(ijk,q,1),pc(ijk,q,2),pc(ijk,q,3),ob);
 				} while(vl.inc());
 			}
 		}
@@ -634,8 +647,9 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		inline bool compute_ghost_cell(v_cell &c,double x,double y,double z,double r) {
 			int ijk;
 			put_locate_block(ijk,x,y,z);
-			double *pp=p[ijk]+4*co[ijk]++,tm=max_radius;
-			*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
+			double tm=max_radius;
+			pc(ijk,co[ijk],3)=r;
+			put_coords(ijk,co[ijk]++,x,y,z);
 			if(r>max_radius) max_radius=r;
 			bool q=compute_cell(c,ijk,co[ijk]-1);
 			co[ijk]--;max_radius=tm;
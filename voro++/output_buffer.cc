@@ -0,0 +1,242 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file output_buffer.cc
+ * \brief Function implementations for the output_buffer and custom_format
+ * classes. */
+
+#include <cmath>
+#include <cstring>
+
+#include "output_buffer.hh"
+
+namespace voro {
+
+/** The powers of ten that are exactly representable as doubles, used when
+ * converting floating point numbers. */
+static const double output_powers_of_ten[23]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,
+	1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+/** The class constructor allocates the array.
+ * \param[in] fp_ the file handle to write to. */
+output_buffer::output_buffer(FILE *fp_) : fp(fp_),
+	buf(new char[output_buffer_size]), be(buf+output_buffer_size), e(buf),
+	own(true) {}
+
+/** This constructor collects output in an array supplied by the caller, such
+ * as a small array on the stack, which must outlive the class.
+ * \param[in] fp_ the file handle to write to.
+ * \param[in] buf_ the array to use.
+ * \param[in] size the size of the array, which must be at least
+ *                 output_number_size. */
+output_buffer::output_buffer(FILE *fp_,char *buf_,int size) : fp(fp_),
+	buf(buf_), be(buf_+size), e(buf_), own(false) {}
+
+/** The class destructor writes any remaining output and frees the array. */
+output_buffer::~output_buffer() {
+	flush();
+	if(own) delete [] buf;
+}
+
+/** Writes the contents of the array to the file. */
+void output_buffer::flush() {
+	if(e>buf) {
+		fwrite(buf,1,e-buf,fp);
+		e=buf;
+	}
+}
+
+/** Adds a string of characters to the buffer.
+ * \param[in] s a pointer to the characters.
+ * \param[in] l the number of characters. */
+void output_buffer::put(const char *s,size_t l) {
+	if(l>size_t(be-e)) {
+		flush();
+		if(l>size_t(be-buf)) {
+			fwrite(s,1,l,fp);
+			return;
+		}
+	}
+	memcpy(e,s,l);
+	e+=l;
+}
+
+/** Adds an integer to the buffer, formatted as by "%d".
+ * \param[in] n the integer. */
+void output_buffer::put_int(int n) {
+	char d[12],*dp=d+12;
+	reserve(output_number_size);
+	unsigned int u=n<0?0u-(unsigned int) n:(unsigned int) n;
+	do {*(--dp)='0'+u%10;u/=10;} while(u>0);
+	if(n<0) *(e++)='-';
+	while(dp<d+12) *(e++)=*(dp++);
+}
+
+/** Adds a floating point number to the buffer, formatted as by "%g".
+ * \param[in] v the number. */
+void output_buffer::put_double(double v) {
+	reserve(output_number_size);
+	if(!fast_double(v)) e+=snprintf(e,output_number_size,"%g",v);
+}
+
+/** Tries to format a floating point number as "%g" would, with six significant
+ * digits. The number is scaled by an exact power of ten so that it has six
+ * digits before the decimal point, which introduces a rounding error of at
+ * most half a unit in the last place. If the fractional part is too close to
+ * one half for this error to matter, the routine gives up.
+ * \param[in] v the number.
+ * \return True if the number was added to the buffer, false if it should be
+ *         converted by the standard library. */
+bool output_buffer::fast_double(double v) {
+	if(v==0) {
+		if(std::signbit(v)) *(e++)='-';
+		*(e++)='0';
+		return true;
+	}
+	double a=std::fabs(v);
+	if(!(a>=1e-16&&a<1e26)) return false;
+
+	// Find the decimal exponent, and scale the number so that it lies in
+	// [1e5,1e6)
+	int ex=int(std::floor(std::log10(a))),k=5-ex;
+	double s=k>=0?a*output_powers_of_ten[k]:a/output_powers_of_ten[-k];
+	if(s<1e5) {
+		ex--;k++;
+		s=k>=0?a*output_powers_of_ten[k]:a/output_powers_of_ten[-k];
+	} else if(s>=1e6) {
+		ex++;k--;
+		s=k>=0?a*output_powers_of_ten[k]:a/output_powers_of_ten[-k];
+	}
+	if(s<1e5||s>=1e6) return false;
+	double f=std::floor(s),fr=s-f;
+	if(std::fabs(fr-0.5)<1e-9) return false;
+	int m=int(f)+(fr>0.5?1:0);
+	if(m==1000000) {m=100000;ex++;}
+
+	// Extract the six digits and count the significant ones
+	char d[6];
+	for(int j=5;j>=0;j--) {d[j]='0'+m%10;m/=10;}
+	int sig=6;
+	while(d[sig-1]=='0') sig--;
+
+	if(v<0) *(e++)='-';
+	if(ex<-4||ex>=6) {
+		*(e++)=*d;
+		if(sig>1) {
+			*(e++)='.';
+			for(int j=1;j<sig;j++) *(e++)=d[j];
+		}
+		*(e++)='e';
+		if(ex<0) {*(e++)='-';ex=-ex;} else *(e++)='+';
+		if(ex>=100) {*(e++)='0'+ex/100;ex%=100;}
+		*(e++)='0'+ex/10;*(e++)='0'+ex%10;
+	} else if(ex>=0) {
+		for(int j=0;j<=ex;j++) *(e++)=d[j];
+		if(sig>ex+1) {
+			*(e++)='.';
+			for(int j=ex+1;j<sig;j++) *(e++)=d[j];
+		}
+	} else {
+		*(e++)='0';*(e++)='.';
+		for(int j=-1;j>ex;j--) *(e++)='0';
+		for(int j=0;j<sig;j++) *(e++)=d[j];
+	}
+	return true;
+}
+
+/** Adds a vector of integers to the buffer, separated by spaces, in the same
+ * format as voro_print_vector().
+ * \param[in] v the vector. */
+void output_buffer::put_vector(std::vector<int> &v) {
+	for(std::vector<int>::iterator it=v.begin();it!=v.end();++it) {
+		if(it!=v.begin()) put(' ');
+		put_int(*it);
+	}
+}
+
+/** Adds a vector of floating point numbers to the buffer, separated by spaces,
+ * in the same format as voro_print_vector().
+ * \param[in] v the vector. */
+void output_buffer::put_vector(std::vector<double> &v) {
+	for(std::vector<double>::iterator it=v.begin();it!=v.end();++it) {
+		if(it!=v.begin()) put(' ');
+		put_double(*it);
+	}
+}
+
+/** Adds a vector of positions to the buffer as bracketed triplets, in the
+ * same format as voro_print_positions().
+ * \param[in] v the vector. */
+void output_buffer::put_positions(std::vector<double> &v) {
+	for(unsigned int k=0;k+2<v.size();k+=3) {
+		if(k>0) put(' ');
+		put('(');put_double(v[k]);
+		put(',');put_double(v[k+1]);
+		put(',');put_double(v[k+2]);
+		put(')');
+	}
+}
+
+/** Adds a vector of face vertex information to the buffer as bracketed lists,
+ * in the same format as voro_print_face_vertices().
+ * \param[in] v the vector. */
+void output_buffer::put_face_vertices(std::vector<int> &v) {
+	int j,k=0,l,s=v.size();
+	while(k<s) {
+		if(k>0) put(' ');
+		l=v[k++];
+		put('(');
+		for(j=k+l;k<j;k++) {
+			if(k>j-l) put(',');
+			put_int(v[k]);
+		}
+		put(')');
+	}
+}
+
+/** The class constructor splits a custom format string into a list of
+ * operations. Any percent sign that isn't followed by a recognized control
+ * character is kept as literal text, and a percent sign at the end of the
+ * string is ignored.
+ * \param[in] format the custom format string. */
+custom_format::custom_format(const char *format) {
+	const char *fp=format,*t=format;
+	while(*fp!=0) {
+		if(*fp=='%') {
+			if(strchr("ixyzqrwpPomgEesFAaftlnvcC",fp[1])!=NULL&&fp[1]!=0) {
+				add_text(t,fp-t);
+				op o={fp[1],0,0};
+				ops.push_back(o);
+				t=fp+=2;
+				continue;
+			}
+			if(fp[1]==0) {
+				add_text(t,fp-t);
+				t=++fp;
+				continue;
+			}
+			fp++;
+		}
+		fp++;
+	}
+	add_text(t,fp-t);
+}
+
+/** Adds a piece of literal text to the list of operations, merging it with
+ * the previous operation if that was also literal text.
+ * \param[in] s a pointer to the text.
+ * \param[in] l the length of the text. */
+void custom_format::add_text(const char *s,int l) {
+	if(l==0) return;
+	if(!ops.empty()&&ops.back().code==0) ops.back().len+=l;
+	else {
+		op o={0,int(text.size()),l};
+		ops.push_back(o);
+	}
+	text.append(s,l);
+}
+
+}
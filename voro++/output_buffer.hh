@@ -0,0 +1,118 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file output_buffer.hh
+ * \brief Header file for the output_buffer and custom_format classes, which
+ * are used to write the custom output of the Voronoi cells. */
+
+#ifndef VOROPP_OUTPUT_BUFFER_HH
+#define VOROPP_OUTPUT_BUFFER_HH
+
+#include <cstdio>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "config.hh"
+
+namespace voro {
+
+/** The size of the output_buffer array, in bytes. */
+const int output_buffer_size=1<<16;
+
+/** The size of the array that is used by an output_buffer on the stack, when
+ * writing a single cell. This must be at least output_number_size. */
+const int output_small_buffer_size=1<<10;
+
+/** The space that is reserved in an output_buffer for each number. */
+const int output_number_size=32;
+
+/** \brief Class for writing formatted output to a file in large blocks.
+ *
+ * This class collects output in an array and writes it to a file once the
+ * array is full, or when the buffer is flushed or destroyed. Numbers are
+ * converted by hand, giving exactly the same characters as the "%d" and "%g"
+ * formats of printf(), but without the cost of parsing the format and locking
+ * the file for each number. Floating point numbers that can't be converted
+ * safely by the fast path, such as those very close to a rounding boundary,
+ * are passed to snprintf(). */
+class output_buffer {
+	public:
+		/** A scratch vector of integers for the cell output routines,
+		 * kept here so that its memory is reused between cells. */
+		std::vector<int> vi;
+		/** A scratch vector of floating point numbers for the cell
+		 * output routines. */
+		std::vector<double> vd;
+		output_buffer(FILE *fp_);
+		output_buffer(FILE *fp_,char *buf_,int size);
+		~output_buffer();
+		void flush();
+		/** Adds a character to the buffer.
+		 * \param[in] c the character to add. */
+		inline void put(char c) {
+			if(e==be) flush();
+			*(e++)=c;
+		}
+		void put(const char *s,size_t l);
+		void put_int(int n);
+		void put_double(double v);
+		void put_vector(std::vector<int> &v);
+		void put_vector(std::vector<double> &v);
+		void put_positions(std::vector<double> &v);
+		void put_face_vertices(std::vector<int> &v);
+	private:
+		/** The file to write to. */
+		FILE *fp;
+		/** The array that output is collected in. */
+		char *buf;
+		/** The end of the array. */
+		char *be;
+		/** The end of the output in the array. */
+		char *e;
+		/** Whether the array was allocated by this class, and so
+		 * should be freed when it is destroyed. */
+		bool own;
+		/** Makes sure that there is space for a number of characters
+		 * in the array, flushing it if necessary.
+		 * \param[in] l the number of characters. */
+		inline void reserve(int l) {
+			if(be-e<l) flush();
+		}
+		bool fast_double(double v);
+};
+
+/** \brief Class holding a custom output format string, split into a list of
+ * operations.
+ *
+ * The format string (see the "-hc" option of the command-line utility) is
+ * scanned once when this class is constructed, and it can then be used to
+ * write the output of any number of cells with
+ * voronoicell_base::output_custom(). */
+class custom_format {
+	public:
+		/** \brief A single operation of the format string. */
+		struct op {
+			/** The control character of the operation, or zero to
+			 * write a piece of literal text. */
+			char code;
+			/** The position of the literal text in the text string. */
+			int start;
+			/** The length of the literal text. */
+			int len;
+		};
+		/** The list of operations. */
+		std::vector<op> ops;
+		/** The literal text of the format string. */
+		std::string text;
+		custom_format(const char *format);
+	private:
+		void add_text(const char *s,int l);
+};
+
+}
+
+#endif
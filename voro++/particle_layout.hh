@@ -0,0 +1,67 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file particle_layout.hh
+ * \brief Header file for the storage policies that set how the container
+ * classes lay out particle coordinates within each block. */
+
+#ifndef VOROPP_PARTICLE_LAYOUT_HH
+#define VOROPP_PARTICLE_LAYOUT_HH
+
+#include "config.hh"
+
+namespace voro {
+
+/** \brief Storage policy that interleaves the coordinates of each particle.
+ *
+ * A block holding particles of ps floating point numbers each is stored as
+ * x0,y0,z0,(r0),x1,y1,z1,(r1),..., which is the original voro++ layout. */
+struct particle_aos {
+	/** Returns the offset of a coordinate within a block array.
+	 * \param[in] ps the number of floating point numbers per particle.
+	 * \param[in] m the number of particles the block has memory for.
+	 * \param[in] l the index of the particle within the block.
+	 * \param[in] c the coordinate (0 to 3 for x, y, z and r). */
+	static inline int at(int ps,int m,int l,int c) {return ps*l+c;}
+	/** Returns the distance between the same coordinate of two
+	 * consecutive particles.
+	 * \param[in] ps the number of floating point numbers per particle. */
+	static inline int step(int ps) {return ps;}
+	/** Copies the particles of a block into a larger array.
+	 * \param[in] dst the new array, with memory for nm particles.
+	 * \param[in] src the old array, with memory for om particles.
+	 * \param[in] ps the number of floating point numbers per particle.
+	 * \param[in] n the number of particles stored in the block. */
+	static inline void grow(double *dst,const double *src,int ps,int n,int om,int nm) {
+		for(int l=0;l<ps*n;l++) dst[l]=src[l];
+	}
+};
+
+/** \brief Storage policy that keeps separate runs of each coordinate.
+ *
+ * A block with memory for m particles is stored as m x coordinates, followed
+ * by m y coordinates, m z coordinates, and for the polydisperse containers m
+ * radii. This lets the cutting loops load the coordinates of consecutive
+ * particles with single vector loads. */
+struct particle_soa {
+	static inline int at(int ps,int m,int l,int c) {return c*m+l;}
+	static inline int step(int ps) {return 1;}
+	static inline void grow(double *dst,const double *src,int ps,int n,int om,int nm) {
+		for(int c=0;c<ps;c++) for(int l=0;l<n;l++) dst[c*nm+l]=src[c*om+l];
+	}
+};
+
+#if VOROPP_SOA_PARTICLES
+typedef particle_soa particle_layout;
+#else
+/** The storage policy used by all of the container classes, selected at
+ * compile time by the VOROPP_SOA_PARTICLES macro. */
+typedef particle_aos particle_layout;
+#endif
+
+}
+
+#endif
@@ -0,0 +1,260 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file particle_reader.cc
+ * \brief Function implementations for the particle_reader class. */
+
+#include <climits>
+#include <cstring>
+#include <string>
+
+#include "common.hh"
+#include "particle_reader.hh"
+
+#if (defined(__unix__)||defined(__APPLE__))&&!defined(__EMSCRIPTEN__)
+#define VOROPP_MMAP_IMPORT
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace voro {
+
+/** The powers of ten that are exactly representable as doubles, used by the
+ * fast path of the text parser. */
+static const double exact_powers_of_ten[23]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,
+	1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+/** The class constructor memory-maps the file if it is a regular file, and
+ * otherwise sets up a buffer to read it into. It then checks whether the file
+ * starts with the header of the binary format.
+ * \param[in] fp_ the file handle to read from.
+ * \param[in] nc_ the number of coordinates per particle, 3 for positions only
+ *                or 4 for positions and radii. */
+particle_reader::particle_reader(FILE *fp_,int nc_) : binary(false), fp(fp_),
+	nc(nc_), buf(NULL), map(NULL), map_size(0), pos(NULL), end(NULL),
+	eof(false), left(0) {
+	const int one=1;
+	swap=*reinterpret_cast<const char*>(&one)==0;
+#ifdef VOROPP_MMAP_IMPORT
+	struct stat st;
+	long off=ftell(fp);
+	if(off>=0&&fstat(fileno(fp),&st)==0&&S_ISREG(st.st_mode)&&st.st_size>off) {
+		void *m=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fileno(fp),0);
+		if(m!=MAP_FAILED) {
+			map=static_cast<char*>(m);map_size=st.st_size;
+			madvise(m,map_size,MADV_SEQUENTIAL);
+			pos=map+off;end=map+map_size;eof=true;
+		}
+	}
+#endif
+	if(map==NULL) {
+		buf=new char[particle_read_block];
+		pos=end=buf;
+	}
+	if(fill(8)&&memcmp(pos,binary_particle_magic,8)==0) read_binary_header();
+}
+
+/** The class destructor frees the buffer or unmaps the file. For a mapped
+ * file, the file position is moved past the data that was read, as it would
+ * be if the file had been read normally. */
+particle_reader::~particle_reader() {
+#ifdef VOROPP_MMAP_IMPORT
+	if(map!=NULL) {
+		fseek(fp,pos-map,SEEK_SET);
+		munmap(map,map_size);
+	}
+#endif
+	delete [] buf;
+}
+
+/** Reads the next particle from the file.
+ * \param[out] n the ID of the particle.
+ * \param[out] v an array to store the nc coordinates of the particle in.
+ * \return True if a particle was read, false if the end of the file was
+ * reached. If the file ends partway through a particle, or holds something
+ * that can't be interpreted as a particle, then the routine causes a fatal
+ * error. */
+bool particle_reader::next(int &n,double *v) {
+	return binary?binary_next(n,v):text_next(n,v);
+}
+
+/** Makes sure that a number of unread bytes are available, reading more of the
+ * file into the buffer if necessary.
+ * \param[in] need the number of bytes required.
+ * \return True if the bytes are available, false if the file ends first or
+ * the bytes don't fit in the buffer. */
+bool particle_reader::fill(size_t need) {
+	while(size_t(end-pos)<need) {
+		if(eof||need>size_t(particle_read_block)) return false;
+		size_t l=end-pos;
+		memmove(buf,pos,l);
+		size_t r=fread(buf+l,1,particle_read_block-l,fp);
+		if(r<particle_read_block-l) {
+			if(ferror(fp)) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+			eof=true;
+		}
+		pos=buf;end=buf+l+r;
+	}
+	return true;
+}
+
+/** Skips over whitespace.
+ * \return True if a non-whitespace character follows, false if the end of
+ * the file was reached. */
+bool particle_reader::skip_space() {
+	while(true) {
+		while(pos<end&&is_space(*pos)) pos++;
+		if(pos<end) return true;
+		if(!fill(1)) return false;
+	}
+}
+
+/** Finds the end of the token starting at the current position, reading more
+ * of the file if the token runs past the end of the buffer.
+ * \param[out] e a pointer to the character after the token.
+ * \return True if the whole token is available, false if it is too long to
+ * fit in the buffer. */
+bool particle_reader::token(const char *&e) {
+	size_t l=0;
+	while(true) {
+		const char *q=pos+l;
+		while(q<end&&!is_space(*q)) q++;
+		l=q-pos;
+		if(q<end||eof) {e=q;return true;}
+		if(!fill(l+1)&&!eof) return false;
+	}
+}
+
+/** Reads the next particle from a text file.
+ * \param[out] n the ID of the particle.
+ * \param[out] v an array to store the coordinates of the particle in.
+ * \return True if a particle was read, false at the end of the file. */
+bool particle_reader::text_next(int &n,double *v) {
+	if(!skip_space()) return false;
+	if(!parse_int(n)) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	for(int c=0;c<nc;c++)
+		if(!skip_space()||!parse_double(v[c])) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	return true;
+}
+
+/** Parses an integer at the current position, which must not be whitespace.
+ * Leading zeros are skipped, and values outside the range of an int are
+ * rejected.
+ * \param[out] n the integer.
+ * \return True if an integer was parsed, false otherwise. */
+bool particle_reader::parse_int(int &n) {
+	const char *e;
+	if(!token(e)) return false;
+	const char *q=pos,*d;
+	bool neg=false;
+	if(*q=='-'||*q=='+') neg=*(q++)=='-';
+	for(d=q;q<e&&*q=='0';q++);
+	const char *f=q;
+	double m=0;
+	for(;q<e&&*q>='0'&&*q<='9';q++) {
+		if(q-f==10) return false;
+		m=10*m+(*q-'0');
+	}
+	if(q==d) return false;
+	if(neg?-m<INT_MIN:m>INT_MAX) return false;
+	n=neg?-int(m-1)-1:int(m);
+	pos=q;
+	return true;
+}
+
+/** Parses a floating point number at the current position, which must not be
+ * whitespace. Numbers with at most 19 significant digits whose mantissa is
+ * below 2^53 and whose decimal exponent is at most 22 in magnitude are
+ * converted with a single correctly rounded multiplication or division.
+ * Anything else is passed to strtod(), so the result is always the same as
+ * the standard library's.
+ * \param[out] v the number.
+ * \return True if a number was parsed, false otherwise. */
+bool particle_reader::parse_double(double &v) {
+	const char *e;
+	if(!token(e)) return false;
+	const char *q=pos,*d;
+	bool neg=false;
+	if(*q=='-'||*q=='+') neg=*(q++)=='-';
+	double m=0;
+	int nd=0,ex=0;
+	for(d=q;q<e&&*q>='0'&&*q<='9';q++,nd++) m=10*m+(*q-'0');
+	if(q<e&&*q=='.') for(q++;q<e&&*q>='0'&&*q<='9';q++,nd++,ex--) m=10*m+(*q-'0');
+	if(nd>0&&q<e&&(*q=='e'||*q=='E')) {
+		q++;
+		bool eneg=false;
+		if(q<e&&(*q=='-'||*q=='+')) eneg=*(q++)=='-';
+		int x=0;
+		for(d=q;q<e&&*q>='0'&&*q<='9'&&x<10000;q++) x=10*x+(*q-'0');
+		if(q==d) nd=0;
+		ex+=eneg?-x:x;
+	}
+	if(q==e&&nd>0&&nd<=19&&m<9007199254740992.0&&ex>=-22&&ex<=22) {
+		double w=m;
+		w=ex<0?w/exact_powers_of_ten[-ex]:w*exact_powers_of_ten[ex];
+		v=neg?-w:w;
+		pos=e;
+		return true;
+	}
+
+	// Fall back to the standard library for anything unusual
+	std::string s(pos,e);
+	char *r;
+	v=strtod(s.c_str(),&r);
+	if(r==s.c_str()) return false;
+	pos+=r-s.c_str();
+	return true;
+}
+
+/** Reads a 32-bit little-endian integer.
+ * \param[in] p a pointer to the first byte of the integer. */
+unsigned int particle_reader::get32(const char *p) {
+	unsigned int u;
+	memcpy(&u,p,4);
+	if(swap) u=(u>>24)|((u>>8)&0xff00)|((u<<8)&0xff0000)|(u<<24);
+	return u;
+}
+
+/** Reads a little-endian double.
+ * \param[in] p a pointer to the first byte of the number. */
+double particle_reader::get_double(const char *p) {
+	double v;
+	if(swap) {
+		char b[8];
+		for(int j=0;j<8;j++) b[j]=p[7-j];
+		memcpy(&v,b,8);
+	} else memcpy(&v,p,8);
+	return v;
+}
+
+/** Reads the header of a binary file, checking that its version and number
+ * of coordinates match. */
+void particle_reader::read_binary_header() {
+	if(!fill(binary_particle_header)) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	if(get32(pos+8)!=1) voro_fatal_error("Unknown binary particle file version",VOROPP_FILE_ERROR);
+	if(get32(pos+12)!=static_cast<unsigned int>(nc)) voro_fatal_error("Binary particle file has the wrong number of coordinates",VOROPP_FILE_ERROR);
+	left=get32(pos+16)+4294967296.0*get32(pos+20);
+	pos+=binary_particle_header;
+	binary=true;
+}
+
+/** Reads the next particle from a binary file.
+ * \param[out] n the ID of the particle.
+ * \param[out] v an array to store the coordinates of the particle in.
+ * \return True if a particle was read, false once all of the particles given
+ * in the header have been read. */
+bool particle_reader::binary_next(int &n,double *v) {
+	if(left==0) return false;
+	if(!fill(4+8*nc)) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	n=int(get32(pos));
+	for(int c=0;c<nc;c++) v[c]=get_double(pos+4+8*c);
+	pos+=4+8*nc;
+	left--;
+	return true;
+}
+
+}
@@ -0,0 +1,101 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file particle_reader.hh
+ * \brief Header file for the particle_reader class, which reads the particle
+ * files that the container classes import. */
+
+#ifndef VOROPP_PARTICLE_READER_HH
+#define VOROPP_PARTICLE_READER_HH
+
+#include <cstdio>
+#include <cstddef>
+
+#include "config.hh"
+
+namespace voro {
+
+/** The eight characters at the start of a binary particle file. */
+const char binary_particle_magic[8]={'V','O','R','O','P','A','R','T'};
+
+/** The size of the header of a binary particle file, in bytes. */
+const int binary_particle_header=24;
+
+/** The size of the blocks that particle files are read in when they can't be
+ * memory-mapped, in bytes. */
+const int particle_read_block=1<<20;
+
+/** \brief Class for reading particles from a text or binary file.
+ *
+ * The import routines of the container classes use this class to read their
+ * particles. A text file holds one particle per line: an integer ID followed
+ * by the x, y, and z coordinates, plus a radius for the polydisperse classes.
+ * Instead of calling fscanf() for each particle, the file is read in large
+ * blocks and the numbers are parsed directly from memory. Any number that the
+ * fast path can't convert exactly is passed to strtod(), so the values are
+ * identical to the ones fscanf() would give.
+ *
+ * A binary file starts with a 24 byte header: the eight characters
+ * "VOROPART", a 32-bit version number (1), a 32-bit number of coordinates per
+ * particle (3, or 4 with radii), and a 64-bit number of particles. Each
+ * particle is then stored as a 32-bit integer ID followed by its coordinates
+ * as doubles. All numbers are little-endian. Binary files are recognized from
+ * their header, so they can be passed to any import routine.
+ *
+ * Where possible, regular files are memory-mapped instead of being read. */
+class particle_reader {
+	public:
+		/** Whether the file is in the binary format. */
+		bool binary;
+		particle_reader(FILE *fp_,int nc_);
+		~particle_reader();
+		bool next(int &n,double *v);
+	private:
+		/** The file being read. */
+		FILE *fp;
+		/** The number of coordinates per particle. */
+		const int nc;
+		/** The buffer that the file is read into, if it isn't
+		 * memory-mapped. */
+		char *buf;
+		/** The memory-mapped file, or a null pointer if the file is
+		 * being read into the buffer. */
+		char *map;
+		/** The size of the memory-mapped region. */
+		size_t map_size;
+		/** The next unread byte. */
+		const char *pos;
+		/** The end of the bytes available in the buffer or mapping. */
+		const char *end;
+		/** Whether the end of the file has been reached, so that no
+		 * more bytes will become available. */
+		bool eof;
+		/** The number of particles left to read from a binary file,
+		 * held as a double so that it can count past 2^32 in C++98. */
+		double left;
+		/** Whether binary numbers need to be byte-swapped, because
+		 * the machine is big-endian. */
+		bool swap;
+		bool fill(size_t need);
+		bool skip_space();
+		bool text_next(int &n,double *v);
+		bool binary_next(int &n,double *v);
+		bool token(const char *&e);
+		bool parse_int(int &n);
+		bool parse_double(double &v);
+		void read_binary_header();
+		/** Tests whether a character is whitespace, in the same way as
+		 * isspace() in the C locale. */
+		static inline bool is_space(char c) {
+			return c==' '||(c>='\t'&&c<='\r');
+		}
+		unsigned int get32(const char *p);
+		double get_double(const char *p);
+};
+
+}
+
+#endif
@@ -9,10 +9,15 @@
  */
 
 #include <cmath>
+#include <vector>
 
 #include "config.hh"
 #include "pre_container.hh"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace voro {
 
 /** The class constructor sets up the geometry of container, initializing the
@@ -94,46 +99,107 @@ void pre_container_poly::put(int n,double x,double y,double z,double r) {
 #endif
 }
 
-/** Transfers the particles stored within the class to a container class.
- * \param[in] con the container class to transfer to. */
-void pre_container::setup(container &con) {
-	int **c_id=pre_id,*idp,*ide,n;
-	double **c_p=pre_p,*pp,x,y,z;
-	while(c_id<end_id) {
-		idp=*(c_id++);ide=idp+pre_container_chunk_size;
-		pp=*(c_p++);
-		while(idp<ide) {
-			n=*(idp++);x=*(pp++);y=*(pp++);z=*(pp++);
-			con.put(n,x,y,z);
+/** Transfers the particles stored within the class to a container, in the
+ * same arrangement that putting them one at a time would give. The particles
+ * are sorted into their blocks with a counting sort, so that each block's
+ * memory is allocated once at its final size: the block of each particle is
+ * found and the particles in each block are counted, the blocks are resized,
+ * and the particles are then copied into place. If the library is compiled
+ * with OpenMP, each thread handles a contiguous range of the particles in
+ * both passes, and the threads' counts give each one its own range of slots
+ * within every block, so the order within each block is unchanged. Since each
+ * thread keeps a count for every block, the number of threads is limited so
+ * that there are no more counts than particles.
+ * \param[in] con the container to transfer to.
+ * \param[in] vo an ordering class in which to record where each particle was
+ *               stored, or a null pointer if this isn't required.
+ * \return The maximum radius of the transferred particles, if they have
+ *         radii. */
+template<class c_class>
+double pre_container_base::bulk_setup(c_class &con,particle_order *vo) {
+	const int n=total_particles(),nxyz=con.nxyz,cs=pre_container_chunk_size;
+	int nt=1;
+#ifdef _OPENMP
+	nt=omp_get_max_threads();
+	if(nt>n/pre_container_chunk_size+1) nt=n/pre_container_chunk_size+1;
+
+	// Each thread needs its own count for every block, so limit the
+	// number of threads to keep the counts no bigger than the array of
+	// particle blocks below
+	if(double(nt)*nxyz>n) nt=n/nxyz>1?n/nxyz:1;
+#endif
+	std::vector<int> blk(n),cnt(static_cast<size_t>(nt)*nxyz,0),q(vo==NULL?0:n);
+	double mr=0;
+
+	// Find the block of each particle, and count how many particles each
+	// thread will put into each block
+#pragma omp parallel for num_threads(nt) schedule(static,1)
+	for(int t=0;t<nt;t++) {
+		int *c=&cnt[0]+static_cast<size_t>(t)*nxyz,ijk;
+		int k=int(double(n)*t/nt),ke=int(double(n)*(t+1)/nt);
+		for(;k<ke;k++) {
+			double *pp=pre_p[k/cs]+ps*(k%cs),x=*pp,y=pp[1],z=pp[2];
+			if(con.put_remap(ijk,x,y,z)) {blk[k]=ijk;c[ijk]++;}
+			else {
+				blk[k]=-1;
+#if VOROPP_REPORT_OUT_OF_BOUNDS ==1
+				fprintf(stderr,"Out of bounds: (x,y,z)=(%g,%g,%g)\n",x,y,z);
+#endif
+			}
+		}
+	}
+
+	// Turn the counts into the first slot that each thread will fill in
+	// each block, and allocate the memory for all the blocks at once
+	std::vector<int> nm(nxyz);
+	for(int ijk=0;ijk<nxyz;ijk++) {
+		int s=con.co[ijk],m;
+		for(int t=0;t<nt;t++) {
+			int &c=cnt[static_cast<size_t>(t)*nxyz+ijk];
+			m=c;c=s;s+=m;
 		}
+		nm[ijk]=s;
 	}
-	idp=*c_id;
-	pp=*c_p;
-	while(idp<ch_id) {
-		n=*(idp++);x=*(pp++);y=*(pp++);z=*(pp++);
-		con.put(n,x,y,z);
+	con.set_particle_memory(&nm[0]);
+
+	// Copy the particles into place, remapping their positions again if
+	// the container is periodic
+	const bool prd=con.xperiodic||con.yperiodic||con.zperiodic;
+#pragma omp parallel for num_threads(nt) schedule(static,1) reduction(max:mr)
+	for(int t=0;t<nt;t++) {
+		int *c=&cnt[0]+static_cast<size_t>(t)*nxyz,ijk,l;
+		int k=int(double(n)*t/nt),ke=int(double(n)*(t+1)/nt);
+		for(;k<ke;k++) if((ijk=blk[k])>=0) {
+			double *pp=pre_p[k/cs]+ps*(k%cs),x=*pp,y=pp[1],z=pp[2];
+			if(prd) con.put_remap(ijk,x,y,z);
+			l=c[ijk]++;
+			con.id[ijk][l]=pre_id[k/cs][k%cs];
+			con.put_coords(ijk,l,x,y,z);
+			if(ps==4) {
+				con.pc(ijk,l,3)=pp[3];
+				if(mr<pp[3]) mr=pp[3];
+			}
+			if(vo!=NULL) q[k]=l;
+		}
 	}
+
+	// Update the particle counts, and record the ordering if needed
+	for(int ijk=0;ijk<nxyz;ijk++) con.co[ijk]=cnt[static_cast<size_t>(nt-1)*nxyz+ijk];
+	if(vo!=NULL) for(int k=0;k<n;k++) if(blk[k]>=0) vo->add(blk[k],q[k]);
+	return mr;
+}
+
+/** Transfers the particles stored within the class to a container class.
+ * \param[in] con the container class to transfer to. */
+void pre_container::setup(container &con) {
+	bulk_setup(con,NULL);
 }
 
 /** Transfers the particles stored within the class to a container_poly class.
  * \param[in] con the container_poly class to transfer to. */
 void pre_container_poly::setup(container_poly &con) {
-	int **c_id=pre_id,*idp,*ide,n;
-	double **c_p=pre_p,*pp,x,y,z,r;
-	while(c_id<end_id) {
-		idp=*(c_id++);ide=idp+pre_container_chunk_size;
-		pp=*(c_p++);
-		while(idp<ide) {
-			n=*(idp++);x=*(pp++);y=*(pp++);z=*(pp++);r=*(pp++);
-			con.put(n,x,y,z,r);
-		}
-	}
-	idp=*c_id;
-	pp=*c_p;
-	while(idp<ch_id) {
-		n=*(idp++);x=*(pp++);y=*(pp++);z=*(pp++);r=*(pp++);
-		con.put(n,x,y,z,r);
-	}
+	double mr=bulk_setup(con,NULL);
+	if(con.max_radius<mr) con.max_radius=mr;
 }
 
 /** Transfers the particles stored within the class to a container class, also
@@ -141,22 +207,7 @@ void pre_container_poly::setup(container_poly &con) {
  * \param[in] vo the ordering class to use.
  * \param[in] con the container class to transfer to. */
 void pre_container::setup(particle_order &vo,container &con) {
-	int **c_id=pre_id,*idp,*ide,n;
-	double **c_p=pre_p,*pp,x,y,z;
-	while(c_id<end_id) {
-		idp=*(c_id++);ide=idp+pre_container_chunk_size;
-		pp=*(c_p++);
-		while(idp<ide) {
-			n=*(idp++);x=*(pp++);y=*(pp++);z=*(pp++);
-			con.put(vo,n,x,y,z);
-		}
-	}
-	idp=*c_id;
-	pp=*c_p;
-	while(idp<ch_id) {
-		n=*(idp++);x=*(pp++);y=*(pp++);z=*(pp++);
-		con.put(vo,n,x,y,z);
-	}
+	bulk_setup(con,&vo);
 }
 
 /** Transfers the particles stored within the class to a container_poly class,
@@ -164,22 +215,8 @@ void pre_container::setup(particle_order &vo,container &con) {
  * \param[in] vo the ordering class to use.
  * \param[in] con the container_poly class to transfer to. */
 void pre_container_poly::setup(particle_order &vo,container_poly &con) {
-	int **c_id=pre_id,*idp,*ide,n;
-	double **c_p=pre_p,*pp,x,y,z,r;
-	while(c_id<end_id) {
-		idp=*(c_id++);ide=idp+pre_container_chunk_size;
-		pp=*(c_p++);
-		while(idp<ide) {
-			n=*(idp++);x=*(pp++);y=*(pp++);z=*(pp++);r=*(pp++);
-			con.put(vo,n,x,y,z,r);
-		}
-	}
-	idp=*c_id;
-	pp=*c_p;
-	while(idp<ch_id) {
-		n=*(idp++);x=*(pp++);y=*(pp++);z=*(pp++);r=*(pp++);
-		con.put(vo,n,x,y,z,r);
-	}
+	double mr=bulk_setup(con,&vo);
+	if(con.max_radius<mr) con.max_radius=mr;
 }
 
 /** Import a list of particles from an open file stream into the container.
@@ -188,10 +225,10 @@ void pre_container_poly::setup(particle_order &vo,container_poly &con) {
  * causes a fatal error.
  * \param[in] fp the file handle to read from. */
 void pre_container::import(FILE *fp) {
-	int i,j;
-	double x,y,z;
-	while((j=fscanf(fp,"%d %lg %lg %lg",&i,&x,&y,&z))==4) put(i,x,y,z);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_reader pr(fp,3);
+	int i;
+	double v[3];
+	while(pr.next(i,v)) put(i,v[0],v[1],v[2]);
 }
 
 /** Import a list of particles from an open file stream, also storing the order
@@ -200,10 +237,10 @@ void pre_container::import(FILE *fp) {
  * successfully read, then the routine causes a fatal error.
  * \param[in] fp the file handle to read from. */
 void pre_container_poly::import(FILE *fp) {
-	int i,j;
-	double x,y,z,r;
-	while((j=fscanf(fp,"%d %lg %lg %lg %lg",&i,&x,&y,&z,&r))==5) put(i,x,y,z,r);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_reader pr(fp,4);
+	int i;
+	double v[4];
+	while(pr.next(i,v)) put(i,v[0],v[1],v[2],v[3]);
 }
 
 /** Allocates a new chunk of memory for storing particles. */
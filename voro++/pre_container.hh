@@ -65,6 +65,8 @@ class pre_container_base {
 		 * (three for the standard container, four when radius
 		 * information is stored). */
 		const int ps;
+		template<class c_class>
+		double bulk_setup(c_class &con,particle_order *vo);
 		void new_chunk();
 		void extend_chunk_index();
 		/** The size of the chunk index. */
@@ -117,7 +119,7 @@ class pre_container : public pre_container_base {
 		/** Imports particles from a file.
 		 * \param[in] filename the name of the file to read from. */
 		inline void import(const char* filename) {
-			FILE *fp=safe_fopen(filename,"r");
+			FILE *fp=safe_fopen(filename,"rb");
 			import(fp);
 			fclose(fp);
 		}
@@ -149,7 +151,7 @@ class pre_container_poly : public pre_container_base {
 		/** Imports particles from a file.
 		 * \param[in] filename the name of the file to read from. */
 		inline void import(const char* filename) {
-			FILE *fp=safe_fopen(filename,"r");
+			FILE *fp=safe_fopen(filename,"rb");
 			import(fp);
 			fclose(fp);
 		}
@@ -13,8 +13,12 @@
 
 #include <cmath>
 
+#include "particle_layout.hh"
+
 namespace voro {
 
+template<class c_class> class voro_compute;
+
 /** \brief Class containing all of the routines that are specific to computing 
  * the regular Voronoi tessellation.
  *
@@ -22,6 +26,7 @@ namespace voro {
  * and during the Voronoi cell computation, these routines are used to create
  * the regular Voronoi tessellation. */
 class radius_mono {
+	template<class c_class> friend class voro_compute;
 	protected:
 		/** This is called prior to computing a Voronoi cell for a
 		 * given particle to initialize any required constants.
@@ -83,6 +88,10 @@ class radius_poly {
 	public:
 		/** A two-dimensional array holding particle positions and radii. */			
 		double **ppr;
+		/** An array holding the particle memory size of each block,
+		 * needed to locate the radii under the particle_layout storage
+		 * policy. */
+		int *pmem;
 		/** The current maximum radius of any particle, used to
 		 * determine when to cut off the radical Voronoi computation.
 		 * */
@@ -90,13 +99,14 @@ class radius_poly {
 		/** The class constructor sets the maximum particle radius to
 		 * be zero. */
 		radius_poly() : max_radius(0) {}
+	template<class c_class> friend class voro_compute;
 	protected:
 		/** This is called prior to computing a Voronoi cell for a
 		 * given particle to initialize any required constants.
 		 * \param[in] ijk the block that the particle is within.
 		 * \param[in] s the index of the particle within the block. */
 		inline void r_init(int ijk,int s) {
-			r_rad=ppr[ijk][4*s+3]*ppr[ijk][4*s+3];
+			r_rad=r_radius(ijk,s)*r_radius(ijk,s);
 			r_mul=r_rad-max_radius*max_radius;
 		}
 		/** Sets a required constant to be used when carrying out a
@@ -124,7 +134,7 @@ class radius_poly {
 		 * \param[in] q the index of the particle within the block. 
 		 * \return The value with the radius squared subtracted. */
 		inline double r_current_sub(double rs,int ijk,int q) {
-			return rs-ppr[ijk][4*q+3]*ppr[ijk][4*q+3];
+			return rs-r_radius(ijk,q)*r_radius(ijk,q);
 		}
 		/** Scales a plane displacement prior to use in the plane cutting
 		 * algorithm.
@@ -133,7 +143,7 @@ class radius_poly {
 		 * \param[in] q the index of the particle within the block.
 		 * \return The scaled plane displacement. */ 
 		inline double r_scale(double rs,int ijk,int q) {
-			return rs+r_rad-ppr[ijk][4*q+3]*ppr[ijk][4*q+3];
+			return rs+r_rad-r_radius(ijk,q)*r_radius(ijk,q);
 		}
 		/** Scales a plane displacement prior to use in the plane
 		 * cutting algorithm, and also checks if it could possibly cut
@@ -147,11 +157,17 @@ class radius_poly {
 		 * otherwise. */
 		inline bool r_scale_check(double &rs,double mrs,int ijk,int q) {
 			double trs=rs;
-			rs+=r_rad-ppr[ijk][4*q+3]*ppr[ijk][4*q+3];
+			rs+=r_rad-r_radius(ijk,q)*r_radius(ijk,q);
 			return rs<sqrt(mrs*trs);
 		}
 	private:
 		double r_rad,r_mul,r_val;
+		/** Returns the radius of a particle.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block. */
+		inline double r_radius(int ijk,int q) {
+			return ppr[ijk][particle_layout::at(4,pmem[ijk],q,3)];
+		}
 };
 
 }
@@ -24,8 +24,8 @@ voro_compute<c_class>::voro_compute(c_class &con_,int hx_,int hy_,int hz_) :
 	con(con_), boxx(con_.boxx), boxy(con_.boxy), boxz(con_.boxz),
 	xsp(con_.xsp), ysp(con_.ysp), zsp(con_.zsp),
 	hx(hx_), hy(hy_), hz(hz_), hxy(hx_*hy_), hxyz(hxy*hz_), ps(con_.ps),
-	id(con_.id), p(con_.p), co(con_.co), bxsq(boxx*boxx+boxy*boxy+boxz*boxz),
-	mv(0), qu_size(3*(3+hxy+hz*(hx+hy))), wl(con_.wl), mrad(con_.mrad),
+	id(con_.id), p(con_.p), co(con_.co), mem(con_.mem), bxsq(boxx*boxx+boxy*boxy+boxz*boxz),
+	mv(0), qu_size(3*(3+hxy+hz*(hx+hy))), seed_n(0), seed_stamp(0), wl(con_.wl), mrad(con_.mrad),
 	mask(new unsigned int[hxyz]), qu(new int[qu_size]), qu_l(qu+qu_size) {
 	reset_mask();
 }
@@ -47,10 +47,10 @@ template<class c_class>
 inline void voro_compute<c_class>::scan_all(int ijk,double x,double y,double z,int di,int dj,int dk,particle_record &w,double &mrs) {
 	double x1,y1,z1,rs;bool in_block=false;
 	for(int l=0;l<co[ijk];l++) {
-		x1=p[ijk][ps*l]-x;
-		y1=p[ijk][ps*l+1]-y;
-		z1=p[ijk][ps*l+2]-z;
-		rs=con.r_current_sub(x1*x1+y1*y1+z1*z1,ijk,l);
+		x1=pc(ijk,l,0)-x;
+		y1=pc(ijk,l,1)-y;
+		z1=pc(ijk,l,2)-z;
+		rs=rad.r_current_sub(x1*x1+y1*y1+z1*z1,ijk,l);
 		if(rs<mrs) {mrs=rs;w.l=l;in_block=true;}
 	}
 	if(in_block) {w.ijk=ijk;w.di=di;w.dj=dj,w.dk=dk;}
@@ -75,7 +75,7 @@ void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,
 	unsigned int q,*e,*mijk;
 
 	// Init setup for parameters to return
-	w.ijk=-1;mrs=large_number;
+	w.ijk=-1;mrs=large_number;rad=con;
 
 	con.initialize_search(ci,cj,ck,ijk,i,j,k,disp);
 
@@ -111,7 +111,7 @@ void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,
 
 	// Do a quick test to account for the case when the minimum radius is
 	// small enought that no other blocks need to be considered
-	rs=con.r_max_add(mrs);
+	rs=rad.r_max_add(mrs);
 	if(mxs*mxs>rs&&mys*mys>rs&&mzs*mzs>rs) return;
 
 	// Now compute which worklist we are going to use, and set radp and e to
@@ -127,7 +127,7 @@ void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,
 
 		// If mrs is less than the minimum distance to any untested
 		// block, then we are done
-		if(con.r_max_add(mrs)<radp[g]) return;
+		if(rad.r_max_add(mrs)<radp[g]) return;
 		g++;
 
 		// Load in a block off the worklist, permute it with the
@@ -170,7 +170,7 @@ void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,
 
 		// If mrs is less than the minimum distance to any untested
 		// block, then we are done
-		if(con.r_max_add(mrs)<radp[g]) return;
+		if(rad.r_max_add(mrs)<radp[g]) return;
 		g++;
 
 		// Load in a block off the worklist, permute it with the
@@ -204,7 +204,7 @@ void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,
 	}
 
 	// Do a check to see if we've reached the radius cutoff
-	if(con.r_max_add(mrs)<radp[g]) return;
+	if(rad.r_max_add(mrs)<radp[g]) return;
 
 	// We were unable to completely compute the cell based on the blocks in
 	// the worklist, so now we have to go block by block, reading in items
@@ -263,6 +263,35 @@ inline void voro_compute<c_class>::scan_bits_mask_add(unsigned int q,unsigned in
 	} else if((q&b5)==b5&&ek<hz-1) {*(mijk+hxy)=mv;*(qu_e++)=ei;*(qu_e++)=ej;*(qu_e++)=ek+1;}
 }
 
+/** Cuts a Voronoi cell by the particles of a crowded block that could
+ * possibly intersect it, recomputing mrs every refresh_mrs_interval particles
+ * so that particles beyond the shrinking cell are skipped. This is only used
+ * when VOROPP_REFRESH_MRS is nonzero, since it changes which planes are cut
+ * and hence the order in which the cell's vertices and faces are listed.
+ * \param[in,out] c a reference to a voronoicell object.
+ * \param[in] ijk the index of the block to test.
+ * \param[in] (x2,y2,z2) the position of the cell's particle, displaced for
+ *                       the block's periodic image.
+ * \param[in] image whether the block is a periodic image, rather than the
+ *                  block itself.
+ * \param[in,out] mrs the current maximum distance to a Voronoi vertex
+ *                    multiplied by two.
+ * \return False if the Voronoi cell was completely removed, true otherwise. */
+template<class c_class>
+template<class v_cell>
+inline bool voro_compute<c_class>::cut_block_refresh(v_cell &c,int ijk,double x2,double y2,double z2,bool image,double &mrs) {
+	double x1,y1,z1,rs;
+	for(int l=0;l<co[ijk];l++) {
+		if(l>0&&l%refresh_mrs_interval==0) mrs=c.max_radius_squared();
+		x1=pc(ijk,l,0)-x2;
+		y1=pc(ijk,l,1)-y2;
+		z1=pc(ijk,l,2)-z2;
+		rs=x1*x1+y1*y1+z1*z1;
+		if(rad.r_scale_check(rs,mrs,ijk,l)&&!seeded(ijk,l,image)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
+	}
+	return true;
+}
+
 /** This routine computes a Voronoi cell for a single particle in the
  * container. It can be called by the user, but is also forms the core part of
  * several of the main functions, such as store_cell_volumes(), print_all(),
@@ -297,28 +326,38 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 	unsigned int q,*e,*mijk;
 
 	if(!con.initialize_voronoicell(c,ijk,s,ci,cj,ck,i,j,k,x,y,z,disp)) return false;
-	con.r_init(ijk,s);
+	rad=con;rad.r_init(ijk,s);
 
 	// Initialize the Voronoi cell to fill the entire container
 	double crs,mrs;
 
 	int next_count=3,*count_p=(const_cast<int*> (count_list));
 
+	// Cut the cell by any seed particles first, so that it starts the
+	// search below already close to its final size
+	for(l=0;l<seed_n;l++) if(seed_ijk[l]!=ijk||seed_q[l]!=s) {
+		x1=pc(seed_ijk[l],seed_q[l],0)-x;
+		y1=pc(seed_ijk[l],seed_q[l],1)-y;
+		z1=pc(seed_ijk[l],seed_q[l],2)-z;
+		rs=rad.r_scale(x1*x1+y1*y1+z1*z1,seed_ijk[l],seed_q[l]);
+		if(!c.nplane(x1,y1,z1,rs,id[seed_ijk[l]][seed_q[l]])) return false;
+	}
+
 	// Test all particles in the particle's local region first
 	for(l=0;l<s;l++) {
-		x1=p[ijk][ps*l]-x;
-		y1=p[ijk][ps*l+1]-y;
-		z1=p[ijk][ps*l+2]-z;
-		rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
-		if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
+		x1=pc(ijk,l,0)-x;
+		y1=pc(ijk,l,1)-y;
+		z1=pc(ijk,l,2)-z;
+		rs=rad.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
+		if(!seeded(ijk,l,false)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 	}
 	l++;
 	while(l<co[ijk]) {
-		x1=p[ijk][ps*l]-x;
-		y1=p[ijk][ps*l+1]-y;
-		z1=p[ijk][ps*l+2]-z;
-		rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
-		if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
+		x1=pc(ijk,l,0)-x;
+		y1=pc(ijk,l,1)-y;
+		z1=pc(ijk,l,2)-z;
+		rs=rad.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
+		if(!seeded(ijk,l,false)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 		l++;
 	}
 
@@ -375,7 +414,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 
 		// If mrs is less than the minimum distance to any untested
 		// block, then we are done
-		if(con.r_ctest(radp[g],mrs)) return true;
+		if(rad.r_ctest(radp[g],mrs)) return true;
 		g++;
 
 		// Load in a block off the worklist, permute it with the
@@ -408,22 +447,27 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 		// those particles which can't possibly intersect the block.
 		if(co[ijk]>0) {
 			l=0;x2=x-qx;y2=y-qy;z2=z-qz;
-			if(!con.r_ctest(crs,mrs)) {
+#if VOROPP_REFRESH_MRS
+			if(co[ijk]>=refresh_mrs_particles) {
+				if(!cut_block_refresh(c,ijk,x2,y2,z2,qx!=0||qy!=0||qz!=0,mrs)) return false;
+			} else
+#endif
+			if(!rad.r_ctest(crs,mrs)) {
 				do {
-					x1=p[ijk][ps*l]-x2;
-					y1=p[ijk][ps*l+1]-y2;
-					z1=p[ijk][ps*l+2]-z2;
-					rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
-					if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
+					x1=pc(ijk,l,0)-x2;
+					y1=pc(ijk,l,1)-y2;
+					z1=pc(ijk,l,2)-z2;
+					rs=rad.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
+					if(!seeded(ijk,l,qx!=0||qy!=0||qz!=0)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 					l++;
 				} while (l<co[ijk]);
 			} else {
 				do {
-					x1=p[ijk][ps*l]-x2;
-					y1=p[ijk][ps*l+1]-y2;
-					z1=p[ijk][ps*l+2]-z2;
+					x1=pc(ijk,l,0)-x2;
+					y1=pc(ijk,l,1)-y2;
+					z1=pc(ijk,l,2)-z2;
 					rs=x1*x1+y1*y1+z1*z1;
-					if(con.r_scale_check(rs,mrs,ijk,l)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
+					if(rad.r_scale_check(rs,mrs,ijk,l)&&!seeded(ijk,l,qx!=0||qy!=0||qz!=0)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 					l++;
 				} while (l<co[ijk]);
 			}
@@ -457,7 +501,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 
 		// If mrs is less than the minimum distance to any untested
 		// block, then we are done
-		if(con.r_ctest(radp[g],mrs)) return true;
+		if(rad.r_ctest(radp[g],mrs)) return true;
 		g++;
 
 		// Load in a block off the worklist, permute it with the
@@ -494,22 +538,27 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 		// those particles which can't possibly intersect the block.
 		if(co[ijk]>0) {
 			l=0;x2=x-qx;y2=y-qy;z2=z-qz;
-			if(!con.r_ctest(crs,mrs)) {
+#if VOROPP_REFRESH_MRS
+			if(co[ijk]>=refresh_mrs_particles) {
+				if(!cut_block_refresh(c,ijk,x2,y2,z2,qx!=0||qy!=0||qz!=0,mrs)) return false;
+			} else
+#endif
+			if(!rad.r_ctest(crs,mrs)) {
 				do {
-					x1=p[ijk][ps*l]-x2;
-					y1=p[ijk][ps*l+1]-y2;
-					z1=p[ijk][ps*l+2]-z2;
-					rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
-					if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
+					x1=pc(ijk,l,0)-x2;
+					y1=pc(ijk,l,1)-y2;
+					z1=pc(ijk,l,2)-z2;
+					rs=rad.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
+					if(!seeded(ijk,l,qx!=0||qy!=0||qz!=0)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 					l++;
 				} while (l<co[ijk]);
 			} else {
 				do {
-					x1=p[ijk][ps*l]-x2;
-					y1=p[ijk][ps*l+1]-y2;
-					z1=p[ijk][ps*l+2]-z2;
+					x1=pc(ijk,l,0)-x2;
+					y1=pc(ijk,l,1)-y2;
+					z1=pc(ijk,l,2)-z2;
 					rs=x1*x1+y1*y1+z1*z1;
-					if(con.r_scale_check(rs,mrs,ijk,l)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
+					if(rad.r_scale_check(rs,mrs,ijk,l)&&!seeded(ijk,l,qx!=0||qy!=0||qz!=0)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 					l++;
 				} while (l<co[ijk]);
 			}
@@ -526,7 +575,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 	}
 
 	// Do a check to see if we've reached the radius cutoff
-	if(con.r_ctest(radp[g],mrs)) return true;
+	if(rad.r_ctest(radp[g],mrs)) return true;
 
 	// We were unable to completely compute the cell based on the blocks in
 	// the worklist, so now we have to go block by block, reading in items
@@ -600,11 +649,11 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 		if(co[ijk]>0) {
 			l=0;x2=x-qx;y2=y-qy;z2=z-qz;
 			do {
-				x1=p[ijk][ps*l]-x2;
-				y1=p[ijk][ps*l+1]-y2;
-				z1=p[ijk][ps*l+2]-z2;
-				rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
-				if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
+				x1=pc(ijk,l,0)-x2;
+				y1=pc(ijk,l,1)-y2;
+				z1=pc(ijk,l,2)-z2;
+				rs=rad.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
+				if(!seeded(ijk,l,qx!=0||qy!=0||qz!=0)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 				l++;
 			} while (l<co[ijk]);
 		}
@@ -632,13 +681,13 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 template<class c_class>
 template<class v_cell>
 bool voro_compute<c_class>::corner_test(v_cell &c,double xl,double yl,double zl,double xh,double yh,double zh) {
-	con.r_prime(xl*xl+yl*yl+zl*zl);
-	if(c.plane_intersects_guess(xh,yl,zl,con.r_cutoff(xl*xh+yl*yl+zl*zl))) return false;
-	if(c.plane_intersects(xh,yh,zl,con.r_cutoff(xl*xh+yl*yh+zl*zl))) return false;
-	if(c.plane_intersects(xl,yh,zl,con.r_cutoff(xl*xl+yl*yh+zl*zl))) return false;
-	if(c.plane_intersects(xl,yh,zh,con.r_cutoff(xl*xl+yl*yh+zl*zh))) return false;
-	if(c.plane_intersects(xl,yl,zh,con.r_cutoff(xl*xl+yl*yl+zl*zh))) return false;
-	if(c.plane_intersects(xh,yl,zh,con.r_cutoff(xl*xh+yl*yl+zl*zh))) return false;
+	rad.r_prime(xl*xl+yl*yl+zl*zl);
+	if(c.plane_intersects_guess(xh,yl,zl,rad.r_cutoff(xl*xh+yl*yl+zl*zl))) return false;
+	if(c.plane_intersects(xh,yh,zl,rad.r_cutoff(xl*xh+yl*yh+zl*zl))) return false;
+	if(c.plane_intersects(xl,yh,zl,rad.r_cutoff(xl*xl+yl*yh+zl*zl))) return false;
+	if(c.plane_intersects(xl,yh,zh,rad.r_cutoff(xl*xl+yl*yh+zl*zh))) return false;
+	if(c.plane_intersects(xl,yl,zh,rad.r_cutoff(xl*xl+yl*yl+zl*zh))) return false;
+	if(c.plane_intersects(xh,yl,zh,rad.r_cutoff(xl*xh+yl*yl+zl*zh))) return false;
 	return true;
 }
 
@@ -657,13 +706,13 @@ bool voro_compute<c_class>::corner_test(v_cell &c,double xl,double yl,double zl,
 template<class c_class>
 template<class v_cell>
 inline bool voro_compute<c_class>::edge_x_test(v_cell &c,double x0,double yl,double zl,double x1,double yh,double zh) {
-	con.r_prime(yl*yl+zl*zl);
-	if(c.plane_intersects_guess(x0,yl,zh,con.r_cutoff(yl*yl+zl*zh))) return false;
-	if(c.plane_intersects(x1,yl,zh,con.r_cutoff(yl*yl+zl*zh))) return false;
-	if(c.plane_intersects(x1,yl,zl,con.r_cutoff(yl*yl+zl*zl))) return false;
-	if(c.plane_intersects(x0,yl,zl,con.r_cutoff(yl*yl+zl*zl))) return false;
-	if(c.plane_intersects(x0,yh,zl,con.r_cutoff(yl*yh+zl*zl))) return false;
-	if(c.plane_intersects(x1,yh,zl,con.r_cutoff(yl*yh+zl*zl))) return false;
+	rad.r_prime(yl*yl+zl*zl);
+	if(c.plane_intersects_guess(x0,yl,zh,rad.r_cutoff(yl*yl+zl*zh))) return false;
+	if(c.plane_intersects(x1,yl,zh,rad.r_cutoff(yl*yl+zl*zh))) return false;
+	if(c.plane_intersects(x1,yl,zl,rad.r_cutoff(yl*yl+zl*zl))) return false;
+	if(c.plane_intersects(x0,yl,zl,rad.r_cutoff(yl*yl+zl*zl))) return false;
+	if(c.plane_intersects(x0,yh,zl,rad.r_cutoff(yl*yh+zl*zl))) return false;
+	if(c.plane_intersects(x1,yh,zl,rad.r_cutoff(yl*yh+zl*zl))) return false;
 	return true;
 }
 
@@ -682,13 +731,13 @@ inline bool voro_compute<c_class>::edge_x_test(v_cell &c,double x0,double yl,dou
 template<class c_class>
 template<class v_cell>
 inline bool voro_compute<c_class>::edge_y_test(v_cell &c,double xl,double y0,double zl,double xh,double y1,double zh) {
-	con.r_prime(xl*xl+zl*zl);
-	if(c.plane_intersects_guess(xl,y0,zh,con.r_cutoff(xl*xl+zl*zh))) return false;
-	if(c.plane_intersects(xl,y1,zh,con.r_cutoff(xl*xl+zl*zh))) return false;
-	if(c.plane_intersects(xl,y1,zl,con.r_cutoff(xl*xl+zl*zl))) return false;
-	if(c.plane_intersects(xl,y0,zl,con.r_cutoff(xl*xl+zl*zl))) return false;
-	if(c.plane_intersects(xh,y0,zl,con.r_cutoff(xl*xh+zl*zl))) return false;
-	if(c.plane_intersects(xh,y1,zl,con.r_cutoff(xl*xh+zl*zl))) return false;
+	rad.r_prime(xl*xl+zl*zl);
+	if(c.plane_intersects_guess(xl,y0,zh,rad.r_cutoff(xl*xl+zl*zh))) return false;
+	if(c.plane_intersects(xl,y1,zh,rad.r_cutoff(xl*xl+zl*zh))) return false;
+	if(c.plane_intersects(xl,y1,zl,rad.r_cutoff(xl*xl+zl*zl))) return false;
+	if(c.plane_intersects(xl,y0,zl,rad.r_cutoff(xl*xl+zl*zl))) return false;
+	if(c.plane_intersects(xh,y0,zl,rad.r_cutoff(xl*xh+zl*zl))) return false;
+	if(c.plane_intersects(xh,y1,zl,rad.r_cutoff(xl*xh+zl*zl))) return false;
 	return true;
 }
 
@@ -706,13 +755,13 @@ inline bool voro_compute<c_class>::edge_y_test(v_cell &c,double xl,double y0,dou
 template<class c_class>
 template<class v_cell>
 inline bool voro_compute<c_class>::edge_z_test(v_cell &c,double xl,double yl,double z0,double xh,double yh,double z1) {
-	con.r_prime(xl*xl+yl*yl);
-	if(c.plane_intersects_guess(xl,yh,z0,con.r_cutoff(xl*xl+yl*yh))) return false;
-	if(c.plane_intersects(xl,yh,z1,con.r_cutoff(xl*xl+yl*yh))) return false;
-	if(c.plane_intersects(xl,yl,z1,con.r_cutoff(xl*xl+yl*yl))) return false;
-	if(c.plane_intersects(xl,yl,z0,con.r_cutoff(xl*xl+yl*yl))) return false;
-	if(c.plane_intersects(xh,yl,z0,con.r_cutoff(xl*xh+yl*yl))) return false;
-	if(c.plane_intersects(xh,yl,z1,con.r_cutoff(xl*xh+yl*yl))) return false;
+	rad.r_prime(xl*xl+yl*yl);
+	if(c.plane_intersects_guess(xl,yh,z0,rad.r_cutoff(xl*xl+yl*yh))) return false;
+	if(c.plane_intersects(xl,yh,z1,rad.r_cutoff(xl*xl+yl*yh))) return false;
+	if(c.plane_intersects(xl,yl,z1,rad.r_cutoff(xl*xl+yl*yl))) return false;
+	if(c.plane_intersects(xl,yl,z0,rad.r_cutoff(xl*xl+yl*yl))) return false;
+	if(c.plane_intersects(xh,yl,z0,rad.r_cutoff(xl*xh+yl*yl))) return false;
+	if(c.plane_intersects(xh,yl,z1,rad.r_cutoff(xl*xh+yl*yl))) return false;
 	return true;
 }
 
@@ -729,11 +778,11 @@ inline bool voro_compute<c_class>::edge_z_test(v_cell &c,double xl,double yl,dou
 template<class c_class>
 template<class v_cell>
 inline bool voro_compute<c_class>::face_x_test(v_cell &c,double xl,double y0,double z0,double y1,double z1) {
-	con.r_prime(xl*xl);
-	if(c.plane_intersects_guess(xl,y0,z0,con.r_cutoff(xl*xl))) return false;
-	if(c.plane_intersects(xl,y0,z1,con.r_cutoff(xl*xl))) return false;
-	if(c.plane_intersects(xl,y1,z1,con.r_cutoff(xl*xl))) return false;
-	if(c.plane_intersects(xl,y1,z0,con.r_cutoff(xl*xl))) return false;
+	rad.r_prime(xl*xl);
+	if(c.plane_intersects_guess(xl,y0,z0,rad.r_cutoff(xl*xl))) return false;
+	if(c.plane_intersects(xl,y0,z1,rad.r_cutoff(xl*xl))) return false;
+	if(c.plane_intersects(xl,y1,z1,rad.r_cutoff(xl*xl))) return false;
+	if(c.plane_intersects(xl,y1,z0,rad.r_cutoff(xl*xl))) return false;
 	return true;
 }
 
@@ -750,11 +799,11 @@ inline bool voro_compute<c_class>::face_x_test(v_cell &c,double xl,double y0,dou
 template<class c_class>
 template<class v_cell>
 inline bool voro_compute<c_class>::face_y_test(v_cell &c,double x0,double yl,double z0,double x1,double z1) {
-	con.r_prime(yl*yl);
-	if(c.plane_intersects_guess(x0,yl,z0,con.r_cutoff(yl*yl))) return false;
-	if(c.plane_intersects(x0,yl,z1,con.r_cutoff(yl*yl))) return false;
-	if(c.plane_intersects(x1,yl,z1,con.r_cutoff(yl*yl))) return false;
-	if(c.plane_intersects(x1,yl,z0,con.r_cutoff(yl*yl))) return false;
+	rad.r_prime(yl*yl);
+	if(c.plane_intersects_guess(x0,yl,z0,rad.r_cutoff(yl*yl))) return false;
+	if(c.plane_intersects(x0,yl,z1,rad.r_cutoff(yl*yl))) return false;
+	if(c.plane_intersects(x1,yl,z1,rad.r_cutoff(yl*yl))) return false;
+	if(c.plane_intersects(x1,yl,z0,rad.r_cutoff(yl*yl))) return false;
 	return true;
 }
 
@@ -771,11 +820,11 @@ inline bool voro_compute<c_class>::face_y_test(v_cell &c,double x0,double yl,dou
 template<class c_class>
 template<class v_cell>
 inline bool voro_compute<c_class>::face_z_test(v_cell &c,double x0,double y0,double zl,double x1,double y1) {
-	con.r_prime(zl*zl);
-	if(c.plane_intersects_guess(x0,y0,zl,con.r_cutoff(zl*zl))) return false;
-	if(c.plane_intersects(x0,y1,zl,con.r_cutoff(zl*zl))) return false;
-	if(c.plane_intersects(x1,y1,zl,con.r_cutoff(zl*zl))) return false;
-	if(c.plane_intersects(x1,y0,zl,con.r_cutoff(zl*zl))) return false;
+	rad.r_prime(zl*zl);
+	if(c.plane_intersects_guess(x0,y0,zl,rad.r_cutoff(zl*zl))) return false;
+	if(c.plane_intersects(x0,y1,zl,rad.r_cutoff(zl*zl))) return false;
+	if(c.plane_intersects(x1,y1,zl,rad.r_cutoff(zl*zl))) return false;
+	if(c.plane_intersects(x1,y0,zl,rad.r_cutoff(zl*zl))) return false;
 	return true;
 }
 
@@ -805,14 +854,14 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs+=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=bxsq+2*(boxx*xlo+boxy*ylo+boxz*zlo);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=bxsq+2*(boxx*xlo+boxy*ylo-boxz*zlo);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxx*(2*xlo+boxx)+boxy*(2*ylo+boxy)+gzs;
 			}
 		} else if(dj<0) {
@@ -820,27 +869,27 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs+=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=bxsq+2*(boxx*xlo-boxy*ylo+boxz*zlo);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=bxsq+2*(boxx*xlo-boxy*ylo-boxz*zlo);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxx*(2*xlo+boxx)+boxy*(-2*ylo+boxy)+gzs;
 			}
 		} else {
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(rad.r_ctest(crs,mrs)) return true;
 				crs+=gzs;
 			}
 			crs+=gys+boxx*(2*xlo+boxx);
@@ -853,14 +902,14 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs+=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=bxsq+2*(-boxx*xlo+boxy*ylo+boxz*zlo);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=bxsq+2*(-boxx*xlo+boxy*ylo-boxz*zlo);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxx*(-2*xlo+boxx)+boxy*(2*ylo+boxy)+gzs;
 			}
 		} else if(dj<0) {
@@ -868,27 +917,27 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs+=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=bxsq+2*(-boxx*xlo-boxy*ylo+boxz*zlo);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=bxsq+2*(-boxx*xlo-boxy*ylo-boxz*zlo);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxx*(-2*xlo+boxx)+boxy*(-2*ylo+boxy)+gzs;
 			}
 		} else {
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(rad.r_ctest(crs,mrs)) return true;
 				crs+=gzs;
 			}
 			crs+=gys+boxx*(-2*xlo+boxx);
@@ -899,14 +948,14 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(rad.r_ctest(crs,mrs)) return true;
 				crs+=gzs;
 			}
 			crs+=boxy*(2*ylo+boxy);
@@ -915,23 +964,23 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(rad.r_ctest(crs,mrs)) return true;
 				crs+=gzs;
 			}
 			crs+=boxy*(-2*ylo+boxy);
 		} else {
 			if(dk>0) {
-				zlo=dk*boxz-fz;crs=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				zlo=dk*boxz-fz;crs=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
-				zlo=(dk+1)*boxz-fz;crs=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				zlo=(dk+1)*boxz-fz;crs=zlo*zlo;if(rad.r_ctest(crs,mrs)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
 				crs=0;
@@ -958,7 +1007,7 @@ bool voro_compute<c_class>::compute_min_radius(int di,int dj,int dk,double fx,do
 	if(dk>0) {t=dk*boxz-fz;crs+=t*t;}
 	else if(dk<0) {t=(dk+1)*boxz-fz;crs+=t*t;}
 
-	return crs>con.r_max_add(mrs);
+	return crs>rad.r_max_add(mrs);
 }
 
 /** Adds memory to the queue.
@@ -10,9 +10,12 @@
 #ifndef VOROPP_V_COMPUTE_HH
 #define VOROPP_V_COMPUTE_HH
 
+#include <vector>
+
 #include "config.hh"
 #include "worklist.hh"
 #include "cell.hh"
+#include "particle_layout.hh"
 
 namespace voro {
 
@@ -84,6 +87,10 @@ class voro_compute {
 		/** An array holding the number of particles within each
 		 * computational box of the container. */
 		int *co;
+		/** An array holding the particle memory size of each
+		 * computational box, which sets where each coordinate lies
+		 * under the particle_layout storage policy. */
+		int *mem;
 		voro_compute(c_class &con_,int hx_,int hy_,int hz_);
 		/** The class destructor frees the dynamically allocated memory
 		 * for the mask and queue. */
@@ -93,8 +100,90 @@ class voro_compute {
 		}
 		template<class v_cell>
 		bool compute_cell(v_cell &c,int ijk,int s,int ci,int cj,int ck);
+		/** Computes a Voronoi cell held in inline storage, using the
+		 * voronoicell instantiation of the main routine. */
+		template<int nv>
+		inline bool compute_cell(voronoicell_fixed<nv> &c,int ijk,int s,int ci,int cj,int ck) {
+			return compute_cell(static_cast<voronoicell&>(c),ijk,s,ci,cj,ck);
+		}
+		/** Computes a Voronoi cell held in inline storage, using the
+		 * voronoicell_neighbor instantiation of the main routine. */
+		template<int nv>
+		inline bool compute_cell(voronoicell_neighbor_fixed<nv> &c,int ijk,int s,int ci,int cj,int ck) {
+			return compute_cell(static_cast<voronoicell_neighbor&>(c),ijk,s,ci,cj,ck);
+		}
+		/** Computes a Voronoi cell, first cutting it by a list of
+		 * particles that are likely to be its neighbors, such as the
+		 * neighbors from an earlier computation of the cell. The
+		 * search for the remaining cutting particles then terminates
+		 * after very few blocks. The seeds only affect the running
+		 * time, so they can safely include particles that are not
+		 * neighbors.
+		 * \param[in,out] c a reference to a voronoicell object.
+		 * \param[in] ijk the index of the block that the test particle
+		 *                is in.
+		 * \param[in] s the index of the particle within the test block.
+		 * \param[in] (ci,cj,ck) the coordinates of the block that the
+		 *                       test particle is in relative to the
+		 *                       container data structure.
+		 * \param[in] (sijk,sq) arrays of the blocks and indices within
+		 *			the blocks of the seed particles.
+		 * \param[in] n the number of seed particles.
+		 * \return False if the Voronoi cell was completely removed
+		 *         during the computation and has zero volume, true
+		 *         otherwise. */
+		template<class v_cell>
+		inline bool compute_cell_seeded(v_cell &c,int ijk,int s,int ci,int cj,int ck,const int *sijk,const int *sq,int n) {
+			seed_ijk=sijk;seed_q=sq;seed_n=n;
+			mark_seeds();
+			bool r=compute_cell(c,ijk,s,ci,cj,ck);
+			seed_n=0;
+			return r;
+		}
 		void find_voronoi_cell(double x,double y,double z,int ci,int cj,int ck,int ijk,particle_record &w,double &mrs);
 	private:
+		/** Returns a reference to one coordinate of a particle.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] l the index of the particle within the block.
+		 * \param[in] c the coordinate (0 to 3 for x, y, z and r). */
+		inline double &pc(int ijk,int l,int c) {
+			return p[ijk][particle_layout::at(ps,mem[ijk],l,c)];
+		}
+		/** Checks whether a particle is one of the seeds of the
+		 * current compute_cell_seeded() call. Their planes have
+		 * already been cut, and cutting a cell again by a plane
+		 * through one of its faces is slow, so they are skipped.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block.
+		 * \param[in] image whether the particle is being tested as a
+		 *                  periodic image, which is never a seed.
+		 * \return True if the particle is a seed, false otherwise. */
+		inline bool seeded(int ijk,int q,bool image) {
+			if(image||seed_n==0||ijk>=static_cast<int>(seed_mark.size())||seed_mark[ijk]!=seed_stamp) return false;
+			for(int l=seed_head[ijk];l>=0;l=seed_next[l]) if(seed_q[l]==q) return true;
+			return false;
+		}
+		/** Sorts the seeds of the current compute_cell_seeded() call
+		 * into a linked list for each block that holds any, and
+		 * stamps those blocks, so that seeded() only has to look at
+		 * the seeds in the block of the particle being tested. */
+		inline void mark_seeds() {
+			if(++seed_stamp==0) {
+				for(size_t k=0;k<seed_mark.size();k++) seed_mark[k]=0;
+				seed_stamp=1;
+			}
+			if(static_cast<int>(seed_next.size())<seed_n) seed_next.resize(seed_n);
+			for(int l=0;l<seed_n;l++) {
+				int ijk=seed_ijk[l];
+				if(ijk>=static_cast<int>(seed_mark.size())) {
+					seed_mark.resize(ijk+1,0);
+					seed_head.resize(ijk+1);
+				}
+				if(seed_mark[ijk]!=seed_stamp) {seed_mark[ijk]=seed_stamp;seed_head[ijk]=-1;}
+				seed_next[l]=seed_head[ijk];
+				seed_head[ijk]=l;
+			}
+		}
 		/** A constant set to boxx*boxx+boxy*boxy+boxz*boxz, which is
 		 * frequently used in the computation. */
 		const double bxsq;
@@ -103,6 +192,25 @@ class voro_compute {
 		unsigned int mv;
 		/** The current size of the search list. */
 		int qu_size;
+		/** The blocks of the seed particles for the current
+		 * compute_cell_seeded() call. */
+		const int *seed_ijk;
+		/** The indices within their blocks of the seed particles for
+		 * the current compute_cell_seeded() call. */
+		const int *seed_q;
+		/** The number of seed particles, which is zero outside of
+		 * compute_cell_seeded() calls. */
+		int seed_n;
+		/** The value marking the blocks that hold seeds in the current
+		 * compute_cell_seeded() call. */
+		unsigned int seed_stamp;
+		/** For each block, the stamp of the last compute_cell_seeded()
+		 * call that had seeds in it. */
+		std::vector<unsigned int> seed_mark;
+		/** For each stamped block, the first of its seeds. */
+		std::vector<int> seed_head;
+		/** For each seed, the next seed in the same block, or -1. */
+		std::vector<int> seed_next;
 		/** A pointer to the array of worklists. */
 		const unsigned int *wl;
 		/** An pointer to the array holding the minimum distances
@@ -118,6 +226,8 @@ class voro_compute {
 		 * when the queue is full. */
 		int *qu_l;
 		template<class v_cell>
+		inline bool cut_block_refresh(v_cell &c,int ijk,double x2,double y2,double z2,bool image,double &mrs);
+		template<class v_cell>
 		bool corner_test(v_cell &c,double xl,double yl,double zl,double xh,double yh,double zh);
 		template<class v_cell>
 		inline bool edge_x_test(v_cell &c,double x0,double yl,double zl,double x1,double yh,double zh);
@@ -137,6 +247,11 @@ class voro_compute {
 		inline void scan_bits_mask_add(unsigned int q,unsigned int *mijk,int ei,int ej,int ek,int *&qu_e);
 		inline void scan_all(int ijk,double x,double y,double z,int di,int dj,int dk,particle_record &w,double &mrs);
 		void add_list_memory(int*& qu_s,int*& qu_e);
+		/** A copy of the container's radius option, which holds the
+		 * constants for the cell currently being computed. It is
+		 * refreshed from the container at the start of each
+		 * computation, so that the container itself is only read. */
+		typename c_class::r_option rad;
 		/** Resets the mask in cases where the mask counter wraps
 		 * around. */
 		inline void reset_mask() {
@@ -144,6 +259,24 @@ class voro_compute {
 		}
 };
 
+/** \brief Scratch space for computing the cells of one container on several
+ * threads at once.
+ *
+ * The mask, queue, and radius constants that a voro_compute modifies during
+ * a cell computation are private to it, and the particle arrays are only
+ * read. Each thread should therefore create its own context for a container,
+ * and pass it to the container's compute_cell routines. The container must
+ * not be modified while any thread is computing cells from it. */
+template<class c_class>
+class voro_compute_context : public voro_compute<c_class> {
+	public:
+		/** The class constructor sets up a mask and queue of the same
+		 * size as the ones used by the container's own computations.
+		 * \param[in] con_ the container whose cells will be computed. */
+		voro_compute_context(c_class &con_) :
+			voro_compute<c_class>(con_,con_.vc.hx,con_.vc.hy,con_.vc.hz) {}
+};
+
 }
 
 #endif
@@ -9,6 +9,9 @@
 
 #include "cell.cc"
 #include "common.cc"
+#include "column_output.cc"
+#include "output_buffer.cc"
+#include "particle_reader.cc"
 #include "v_base.cc"
 #include "container.cc"
 #include "unitcell.cc"
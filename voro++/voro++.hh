@@ -163,8 +163,9 @@
  * There are four container classes available for general usage: container,
  * container_poly, container_periodic, and container_periodic_poly. Each of
  * these represent a system of particles in a specific three-dimensional
- * geometry. They contain routines for importing particles from a text file,
- * and adding particles individually. They also contain a large number of
+ * geometry. They contain routines for importing particles from a text or
+ * binary file (see the particle_reader class), and adding particles
+ * individually. They also contain a large number of
  * analyzing and outputting the particle system. Internally, the routines that
  * compute Voronoi cells do so by making use of the voro_compute template.
  * Each container class contains routines that tell the voro_compute template
@@ -319,9 +320,13 @@
 
 #include "config.hh"
 #include "common.hh"
+#include "output_buffer.hh"
 #include "cell.hh"
+#include "column_output.hh"
 #include "v_base.hh"
 #include "rad_option.hh"
+#include "particle_layout.hh"
+#include "particle_reader.hh"
 #include "container.hh"
 #include "unitcell.hh"
 #include "container_prd.hh"
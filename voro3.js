@@ -125,17 +125,19 @@ var Voro3 = function () {
         };
         this.update(cells, pts, old_pts);
         
-        this.redo = function() {
+        this.apply = function(which) {
+            var cells = [], pts = [];
             for (var id in moves) {
-                var ind = that.voro.index_from_id(parseInt(id));
-                that.voro.move_cell(ind, moves[id][0]);
+                cells.push(that.voro.index_from_id(parseInt(id)));
+                pts.push(moves[id][which]);
             }
+            that.voro_move_cells(cells, pts);
+        };
+        this.redo = function() {
+            this.apply(0);
         };
         this.undo = function() {
-            for (var id in moves) {
-                var ind = that.voro.index_from_id(parseInt(id));
-                that.voro.move_cell(ind, moves[id][1]);
-            }
+            this.apply(1);
         };
     };
     var SetSymAct = function(sym_op, sym_map) {
@@ -208,7 +210,7 @@ var Voro3 = function () {
     var SetPaletteAct = function(old_pal, new_pal) {
         this.set = function(pal) {
             that.palette = pal;
-            that.voro.set_palette(pal);
+            that.voro_set_palette(pal);
             that.update_geometry();
         };
         this.redo = function() {
@@ -247,6 +249,32 @@ var Voro3 = function () {
             this.tracked_acts.push(act);
         }
     };
+    // these pass arrays to the Voro through its staging buffers in the module heap, w/ one call into the module instead of
+    // one per element.  the heap views are made after both js_* calls, since either may grow (and so move) the heap
+    this.voro_move_cells = function(cells, pts_arr) {
+        var n = cells.length;
+        var cells_ptr = this.voro.js_ints(n);
+        var pts_ptr = this.voro.js_floats(n*3);
+        Module.HEAP32.set(cells, cells_ptr/4);
+        var pts = Module.HEAPF32.subarray(pts_ptr/4, pts_ptr/4 + n*3);
+        for (var i=0; i<n; i++) {
+            pts[i*3] = pts_arr[i][0];
+            pts[i*3+1] = pts_arr[i][1];
+            pts[i*3+2] = pts_arr[i][2];
+        }
+        return this.voro.move_cells(cells_ptr, pts_ptr, n);
+    };
+    this.voro_set_palette = function(palette) {
+        var n = palette.length;
+        var colors_ptr = this.voro.js_floats(n*3);
+        var colors = Module.HEAPF32.subarray(colors_ptr/4, colors_ptr/4 + n*3);
+        for (var i=0; i<n; i++) {
+            colors[i*3] = palette[i][0];
+            colors[i*3+1] = palette[i][1];
+            colors[i*3+2] = palette[i][2];
+        }
+        this.voro.set_palette(colors_ptr, n);
+    };
     this.set_palette = function(palette) {
         var act = new SetPaletteAct(this.palette, palette);
         this.track_act(act);
@@ -276,6 +304,7 @@ var Voro3 = function () {
             this.voro.delete();
         }
         this.voro = new Module.Voro(this.min_point,this.max_point);
+        this.voro.gl_set_indexed(true); // share each cell's vertices between its tris; the geometry gets an index attribute (see alloc_geometry)
         this.sym_map = {};
         this.active_sym = null;
         this.active_sym_name = null;
@@ -300,7 +329,7 @@ var Voro3 = function () {
         this.nuke(scene);
         this.create_voro(min_point, max_point);
         if (palette) {
-            this.voro.set_palette(palette);
+            this.voro_set_palette(palette);
         }
         
         Math.seedrandom(seed);
@@ -312,6 +341,7 @@ var Voro3 = function () {
         } else {
             this.voro.set_fill(fill_level/100.0, Math.random()*2147483648);
         }
+        this.voro.reorder_spatially(); // (after the fill, which picks cells by index, so a seed still generates the same diagram)
         
         this.create_gl_objects(scene);
         
@@ -402,27 +432,49 @@ var Voro3 = function () {
         this.sites_points = new THREE.Points(this.sites_geometry, this.sites_material);
     };
     
+    // subarray() makes a new view on every call, so to tell whether the gl buffers moved we compare what the views are made from:
+    // the heap's ArrayBuffer (replaced when the wasm memory grows), the buffer pointers and their max sizes
+    this.same_alloc = function(key, cached_key) {
+        if (!cached_key || key.length !== cached_key.length) {
+            return false;
+        }
+        for (var i=0; i<key.length; i++) {
+            if (key[i] !== cached_key[i]) {
+                return false;
+            }
+        }
+        return true;
+    };
     this.alloc_geometry = function(geometry, realloc_only) {
         this.verts_ptr = this.voro.gl_vertices();
-        var max_tris = this.voro.gl_max_tris();
-        var array = Module.HEAPF32.subarray(this.verts_ptr/4, this.verts_ptr/4 + max_tris*3*3);
+        var max_verts = this.voro.gl_max_verts();
         var want_colors = this.voro.has_colors();
-        var colors_array;
-        if (want_colors) {
-            var colors_ptr = this.voro.gl_colors();
-            colors_array = Module.HEAPF32.subarray(colors_ptr/4, colors_ptr/4 + max_tris*3*3);
-        }
-        if (realloc_only && array === this.cached_geometry_array && colors_array === this.cached_colors_array) {
+        var colors_ptr = want_colors ? this.voro.gl_colors() : 0;
+        var indexed = this.voro.gl_is_indexed();
+        var index_ptr = indexed ? this.voro.gl_indices() : 0;
+        var max_tris = indexed ? this.voro.gl_max_tris() : 0;
+        var key = [Module.HEAPF32.buffer, this.verts_ptr, max_verts, colors_ptr, index_ptr, max_tris];
+        if (realloc_only && this.same_alloc(key, this.cached_geometry_key)) {
             return;
         }
-        if (this.cached_geometry_array || this.cached_colors_array) {
+        if (this.cached_geometry_key) {
             geometry.dispose();
         }
-        this.cached_colors_array = colors_array;
-        this.cached_geometry_array = array;
-        geometry.addAttribute('position', new THREE.BufferAttribute(array, 3));
+        this.cached_geometry_key = key;
+        var array = Module.HEAPF32.subarray(this.verts_ptr/4, this.verts_ptr/4 + max_verts*3);
+        var colors_array;
+        if (want_colors) {
+            colors_array = Module.HEAPF32.subarray(colors_ptr/4, colors_ptr/4 + max_verts*3);
+        }
+        var index_array;
+        if (indexed) {
+            index_array = Module.HEAPU32.subarray(index_ptr/4, index_ptr/4 + max_tris*3);
+        }
+        // dynamic, so update_geometry can upload just the dirty ranges (static attributes always re-upload the whole buffer)
+        geometry.addAttribute('position', new THREE.BufferAttribute(array, 3).setDynamic(true));
+        geometry.setIndex(index_array ? new THREE.BufferAttribute(index_array, 1).setDynamic(true) : null);
         if (want_colors) {
-            geometry.addAttribute('color', new THREE.BufferAttribute(colors_array, 3));
+            geometry.addAttribute('color', new THREE.BufferAttribute(colors_array, 3).setDynamic(true));
         } else {
             geometry.removeAttribute('color');
         }
@@ -454,14 +506,15 @@ var Voro3 = function () {
         this.preview_verts_ptr = this.voro.gl_wire_vertices();
         var verts_ptr = this.preview_verts_ptr; // just to give it a shorter name
         var max_verts = this.voro.gl_wire_max_verts();
-        var array = Module.HEAPF32.subarray(verts_ptr/4, verts_ptr/4 + max_verts*3);
-        if (realloc_only && array === this.cached_preview_array) {
+        var key = [Module.HEAPF32.buffer, verts_ptr, max_verts];
+        if (realloc_only && this.same_alloc(key, this.cached_preview_key)) {
             return;
         }
-        if (this.cached_preview_array) {
+        if (this.cached_preview_key) {
             geometry.dispose();
         }
-        this.cached_preview_array = array;
+        this.cached_preview_key = key;
+        var array = Module.HEAPF32.subarray(verts_ptr/4, verts_ptr/4 + max_verts*3);
         var vertices = new THREE.BufferAttribute(array, 3);
         geometry.addAttribute('position', vertices);
     };
@@ -479,19 +532,19 @@ var Voro3 = function () {
         this.sites_verts_ptr = this.voro.gl_cell_sites();
         var verts_ptr = this.sites_verts_ptr; // just to give it a shorter name
         var max_verts = this.voro.gl_max_sites();
-        var array = Module.HEAPF32.subarray(verts_ptr/4, verts_ptr/4 + max_verts*3);
         var sizes_ptr = this.voro.gl_cell_site_sizes();
-        var sizes_array = Module.HEAPF32.subarray(sizes_ptr/4, sizes_ptr/4 + max_verts);
-        if (realloc_only && array === this.cached_sites_array && sizes_array === this.caches_sites_sizes_array) {
+        var key = [Module.HEAPF32.buffer, verts_ptr, sizes_ptr, max_verts];
+        if (realloc_only && this.same_alloc(key, this.cached_sites_key)) {
             return;
         }
-        if (this.cached_sites_array || this.caches_sites_sizes_array) {
+        if (this.cached_sites_key) {
             geometry.dispose();
         }
-        this.cached_sites_array = array;
-        this.caches_sites_sizes_array = sizes_array;
-        var vertices = new THREE.BufferAttribute(array, 3);
-        var sizes = new THREE.BufferAttribute(sizes_array, 1);
+        this.cached_sites_key = key;
+        var array = Module.HEAPF32.subarray(verts_ptr/4, verts_ptr/4 + max_verts*3);
+        var sizes_array = Module.HEAPF32.subarray(sizes_ptr/4, sizes_ptr/4 + max_verts);
+        var vertices = new THREE.BufferAttribute(array, 3).setDynamic(true);
+        var sizes = new THREE.BufferAttribute(sizes_array, 1).setDynamic(true);
         geometry.addAttribute('position', vertices);
         geometry.addAttribute('size', sizes);
     };
@@ -572,22 +625,47 @@ var Voro3 = function () {
             pts_arr = sym_pts;
         }
         this.track_move(cells, pts_arr);
-        this.voro.move_cells(cells, pts_arr);
+        this.voro_move_cells(cells, pts_arr);
         this.update_geometry();
     };
+    // marks the range [start, end) of items (each item_size values long) for upload on the next render
+    // three.js only uploads one range per attribute, and resets updateRange.count to -1 once it has, so until then we grow the pending range
+    this.add_update_range = function(attribute, range, item_size) {
+        if (range.end <= range.start) {
+            return;
+        }
+        var r = attribute.updateRange;
+        var start = range.start*item_size, end = range.end*item_size;
+        if (r.count > 0) {
+            start = Math.min(start, r.offset);
+            end = Math.max(end, r.offset + r.count);
+        }
+        r.offset = start;
+        r.count = end - start;
+        attribute.needsUpdate = true;
+    };
     this.update_sites = function() {
         var num_sites = this.voro.cell_count();
         this.alloc_sites(this.sites_geometry, true);
         this.sites_geometry.setDrawRange(0, num_sites);
-        this.sites_geometry.attributes.position.needsUpdate = true;
-        this.sites_geometry.attributes.size.needsUpdate = true;
+        var sites = this.voro.gl_dirty_site_range();
+        this.add_update_range(this.sites_geometry.attributes.position, sites, 3);
+        this.add_update_range(this.sites_geometry.attributes.size, sites, 1);
     };
     this.update_geometry = function () {
         var num_tris = this.voro.gl_tri_count();
         this.alloc_geometry(this.geometry, true);
-        this.geometry.setDrawRange(0, num_tris*3);
-        this.geometry.attributes.position.needsUpdate = true;
+        this.geometry.setDrawRange(0, num_tris*3); // (counts indices, when indexed)
+        var verts = this.voro.gl_dirty_vert_range();
+        this.add_update_range(this.geometry.attributes.position, verts, 3);
+        if (this.geometry.index) {
+            this.add_update_range(this.geometry.index, this.voro.gl_dirty_tri_range(), 3);
+        }
+        if (this.geometry.attributes.color) { // colors are compacted along with the vertices they belong to
+            this.add_update_range(this.geometry.attributes.color, verts, 3);
+        }
         this.update_sites();
+        this.voro.gl_clear_dirty();
     };
     this.update_preview = function() {
         var num_verts = this.voro.gl_wire_vert_count();
@@ -1000,23 +1078,51 @@ var Voro3 = function () {
     this.get_binary_stl_buffer = function() {
         this.verts_ptr = this.voro.gl_vertices();
         var num_tris = this.voro.gl_tri_count();
-        var array = Module.HEAPF32.subarray(this.verts_ptr/4, this.verts_ptr/4 + num_tris*3*3);
-        var buffer = new ArrayBuffer(80+4+num_tris*(4*4*3+2)); // buffer w/ space for whole stl
-        var view = new DataView(buffer);
-        view.setInt32(80, num_tris, true);
+        var array = Module.HEAPF32.subarray(this.verts_ptr/4, this.verts_ptr/4 + this.voro.gl_vert_count()*3);
+        var indices = null;
+        if (this.voro.gl_is_indexed()) {
+            var index_ptr = this.voro.gl_indices();
+            indices = Module.HEAPU32.subarray(index_ptr/4, index_ptr/4 + num_tris*3);
+        }
+        var is_hole = function(i) { // holes left by edits are degenerate tris: all indices (or, unindexed, all corners) are the same
+            if (indices) {
+                return indices[i*3] === indices[i*3+1] && indices[i*3] === indices[i*3+2];
+            }
+            for (var k=0; k<3; k++) {
+                if (array[i*9+k] !== array[i*9+3+k] || array[i*9+k] !== array[i*9+6+k]) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        var num_facets = 0;
         for (var i=0; i<num_tris; i++) {
+            if (!is_hole(i)) {
+                num_facets++;
+            }
+        }
+        var buffer = new ArrayBuffer(80+4+num_facets*(4*4*3+2)); // buffer w/ space for whole stl
+        var view = new DataView(buffer);
+        view.setInt32(80, num_facets, true);
+        var fi = 0;
+        for (i=0; i<num_tris; i++) {
+            if (is_hole(i)) {
+                continue;
+            }
             for (var vi=0; vi<3; vi++) {
                 for (var di=0; di<3; di++) {
-                    view.setFloat32(80+4+i*(4*4*3+2)+4*3*(vi+1)+4*di, array[i*3*3+vi*3+di], true);
+                    var v = indices ? indices[i*3+vi] : i*3+vi;
+                    view.setFloat32(80+4+fi*(4*4*3+2)+4*3*(vi+1)+4*di, array[v*3+di], true);
                 }
             }
+            fi++;
         }
         return buffer;
     };
     
     this.get_text_obj = function(mtlFileName) {
         var i, palettei;
-        var mesh = this.voro.export_index_mesh();
+        var mesh = this.voro.export_index_mesh(true); // (full precision, in case the module was built w/ COMPACT_CELL_CACHE)
         var objText = "";
         if (this.voro.has_colors()) {
             objText += "mtllib " + mtlFileName + "\n";
@@ -1209,16 +1315,20 @@ var Voro3 = function () {
         var cur_pos = offset;
         var num_types = view.getInt32(cur_pos, true);
         cur_pos += 4;
+        var posns = [], types = [];
         for (var i=0; i<num_types; i++) {
             var type = view.getInt32(cur_pos, true); cur_pos += 4;
             var num_pts = view.getInt32(cur_pos, true); cur_pos += 4;
             for (var pi=0; pi<num_pts; pi++) {
-                var x = view.getFloat32(cur_pos, true); cur_pos += 4;
-                var y = view.getFloat32(cur_pos, true); cur_pos += 4;
-                var z = view.getFloat32(cur_pos, true); cur_pos += 4;
-                this.voro.add_cell([x,y,z], type);
+                posns.push(view.getFloat32(cur_pos, true)); cur_pos += 4;
+                posns.push(view.getFloat32(cur_pos, true)); cur_pos += 4;
+                posns.push(view.getFloat32(cur_pos, true)); cur_pos += 4;
+                types.push(type);
             }
         }
+        // one call for all the cells, instead of crossing into the wasm module once per cell
+        this.voro.add_cells(new Float32Array(posns), new Int32Array(types));
+        this.voro.reorder_spatially();
 
         if (cur_pos < view.byteLength) {
             var p_len = view.getInt32(cur_pos, true); cur_pos += 4;
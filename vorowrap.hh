@@ -0,0 +1,1964 @@
+// this will be a wrapper around voro++ functionality, helping exposing it to js (and threejs specifically)
+// the Voro class itself is plain C++, so it can also be built natively (see the 'native' and 'bench' make targets);
+// anything that needs emscripten is kept behind #ifdef EMSCRIPTEN
+
+#ifndef VOROWRAP_HH
+#define VOROWRAP_HH
+
+#include <iostream>
+#include <algorithm>
+#include <unordered_set>
+#include <unordered_map>
+#include <stdlib.h>
+#include <math.h>
+#include <stdint.h>
+
+#ifdef EMSCRIPTEN
+#include <emscripten.h>
+#include <emscripten/bind.h>
+#include <emscripten/val.h>
+#endif
+
+// full diagram builds can be spread over multiple threads; under emscripten this needs a pthreads build (-s USE_PTHREADS=1, served w/ SharedArrayBuffer enabled), otherwise builds are always serial
+#if !defined(EMSCRIPTEN) || defined(__EMSCRIPTEN_PTHREADS__)
+#define VORO_THREADS
+#include <thread>
+#include <atomic>
+#include <memory>
+#endif
+
+#include "voro++/voro++.hh"
+#include "glm/vec3.hpp"
+#include "glm/gtx/norm.hpp"
+
+using namespace std;
+#ifdef EMSCRIPTEN
+using namespace emscripten;
+#endif
+
+// define this to disable all (expensive, debugging-only) sanity checking; INSANITY is recommended for a final build
+#define INSANITY
+// define this to 1 to add the shared faces of neighboring cells that are both toggled 'on'; if the cells are solid, 0 is preferred
+#define ADD_ALL_FACES_ALL_THE_TIME 0
+// the minimum distance between two cells.  If you try to move or add a cell closer to another cell than this, the cell will be 'jittered' away from the colliding cell
+// voro++'s fixed plane tolerance mishandles cells much closer than this; w/ VOROPP_EXACT_PREDICATES its tolerance scales w/ the cells' separation, so
+// only (near-)coincident cells need pushing apart, and by an invisible amount
+#if VOROPP_EXACT_PREDICATES
+#define SHADOW_SEP_DIST 1e-5
+#else
+#define SHADOW_SEP_DIST .003
+#endif
+#define SHADOW_THRESHOLD (SHADOW_SEP_DIST*SHADOW_SEP_DIST)
+// when the average number of cells per voro++ container block grows past this multiple of voro::optimal_particles, the container is rebuilt with a finer grid
+#define REGRID_FACTOR 4
+// builds w/ fewer cells than this per thread aren't worth spreading across threads
+#define MIN_CELLS_PER_BUILD_THREAD 256
+// how far (in 64-slot words) to look for a hole in the gl buffers to reuse, before appending to the end instead
+#define HOLE_SEARCH_WORDS 32
+// initial builds leave GL_BUILD_SLACK free tris (and verts) after every GL_BUILD_SLACK_INTERVAL tris, so edits can grow cells in place
+#define GL_BUILD_SLACK_INTERVAL 256
+#define GL_BUILD_SLACK 32
+// cells that only changed because nearby cells moved are re-cut against a list of candidate neighbors (see recut_cell), unless the
+// list grows past this many cells (e.g. next to a big dragged group), in which case a normal compute_cell is cheaper
+#define RECUT_MAX_CANDIDATES 96
+// CellToTris are allocated this many at a time (see CellToTrisPool)
+#define CELL_POOL_CHUNK 1024
+// define this to 1 (e.g. w/ -DCOMPACT_CELL_CACHE=1) to keep cached cell geometry as floats w/ 16-bit face vertex indices, about halving
+// cache memory; rendering only needs floats anyway, and export_index_mesh(true) recomputes cells in double precision when asked
+#ifndef COMPACT_CELL_CACHE
+#define COMPACT_CELL_CACHE 0
+#endif
+
+#if COMPACT_CELL_CACHE
+typedef float cache_real;
+typedef short cache_face_int;
+#else
+typedef double cache_real;
+typedef int cache_face_int;
+#endif
+
+template<typename T> inline glm::vec3 tovec(const T *vts, int i) {
+    return glm::vec3(vts[i*3], vts[i*3+1], vts[i*3+2]);
+}
+
+inline void jitter(glm::vec3 &pt, double amt) {
+    pt.x+=amt*(rand()%10000)/10000.0;
+    pt.y+=amt*(rand()%10000)/10000.0;
+    pt.z+=amt*(rand()%10000)/10000.0;
+}
+
+// spreads the low 10 bits of v out to every third bit, for morton_key
+inline uint32_t morton_spread(uint32_t v) {
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+// interleaves the bits of pt's coords on a 1024^3 grid over [lo,hi], so sorting by the key puts nearby points near each other
+inline uint32_t morton_key(const glm::vec3 &pt, const glm::vec3 &lo, const glm::vec3 &hi) {
+    uint32_t key = 0;
+    for (int i=0; i<3; i++) {
+        float t = (pt[i]-lo[i]) / (hi[i]-lo[i]);
+        uint32_t g = t <= 0 ? 0 : (t >= 1 ? 1023 : uint32_t(t*1024));
+        key |= morton_spread(g) << i;
+    }
+    return key;
+}
+
+#ifdef INSANITY
+#define SANITY(WHEN) {}
+#else
+#define SANITY(WHEN) {sanity(WHEN);}
+#endif
+
+// indices to connect cell to voro++ container
+struct CellConLink {
+    int ijk;    // block index in voro++ container
+    int q;      // index of the cell within the block (following var naming from c_loops.hh)
+    
+    CellConLink() : ijk(-1), q(-1) {} // invalid / fail-fast defaults
+    CellConLink(const voro::c_loop_base &loop) : ijk(loop.ijk), q(loop.q) {}
+    CellConLink(int ijk, int q) : ijk(ijk), q(q) {}
+
+    bool valid() {
+        return ijk >= 0 && q >= 0;
+    }
+    void set(const voro::c_loop_base &loop) {
+        ijk = loop.ijk;
+        q = loop.q;
+    }
+};
+
+// defining information about cell
+struct Cell {
+    glm::vec3 pos;
+    int type; // 0 is empty, non-zero is non-empty; can use different numbers as tags or material types
+
+    Cell() {}
+    Cell(glm::vec3 pos, int type) : pos(pos), type(type) {}
+};
+
+// a cell's run of entries in one of a CellArena's arrays.  Indexing goes through the array (rather than a pointer into it), so a span
+// stays valid while other caches are added to the arena; only begin()/end()/data() are invalidated by that, so don't add caches while iterating
+template<typename T> struct ArenaSpan {
+    vector<T> *arr;
+    int start, len;
+    
+    ArenaSpan() : arr(0), start(0), len(0) {}
+    
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    T& operator[](size_t i) const { return (*arr)[start+i]; }
+    T* data() const { return len ? &(*arr)[start] : 0; }
+    T* begin() const { return data(); }
+    T* end() const { return data()+len; }
+    vector<T> to_vector() const { return vector<T>(begin(), end()); }
+};
+
+struct CellCache { // computations from a voro++ computed cell; the data itself lives in a CellArena (see CellArena::create)
+    ArenaSpan<cache_face_int> faces; // faces as voro++ likes to store them -- packed as [#vs in f0, f0 v0, f0 v1, ..., #vs in f1, ...]
+    ArenaSpan<cache_real> vertices; // vertex coordinates, indexed by faces array
+    ArenaSpan<int> neighbors; // cells neighboring each face
+    
+    double doublearea(int i, int j, int k) {
+        double a[3] = {
+            vertices[j*3+0]-vertices[i*3+0],
+            vertices[j*3+1]-vertices[i*3+1],
+            vertices[j*3+2]-vertices[i*3+2]
+        };
+        double b[3] = {
+            vertices[k*3+0]-vertices[i*3+0],
+            vertices[k*3+1]-vertices[i*3+1],
+            vertices[k*3+2]-vertices[i*3+2]
+        };
+        double o[3] = {
+            a[1]*b[2]-a[2]*b[1],
+            a[2]*b[0]-a[0]*b[2],
+            a[0]*b[1]-a[1]*b[0]
+        };
+        return sqrt(o[0]*o[0]+o[1]*o[1]+o[2]*o[2]);
+    }
+    double face_size(int face) {
+        size_t i=0, fi=0;
+        for (; fi<face && i<faces.size(); fi++,i+=faces[i]+1) {}
+        double area = 0;
+        if (i<faces.size()) {
+            int vicount = faces[i];
+            int vs[3] = {faces[i+1], 0, faces[i+2]};
+            for (int j = i+3; j < i+vicount+1; j++) { // facev
+                vs[1] = faces[j];
+                
+                area += doublearea(vs[0],vs[1],vs[2]);
+                
+                vs[2] = vs[1];
+            }
+        }
+        return area*.5;
+    }
+};
+
+struct CellToTris {
+    vector<int> tri_inds; // indices into the GLBufferManager's vertices array, indicating which triangles are from this cell
+                            // i.e. if tri_inds[0]==47, then vertices[47*3] ... vertices[47*3+2] (incl.) are from this cell
+    vector<short> tri_faces;
+    vector<int> vert_inds; // (indexed mode only) indices into the GLBufferManager's vertices array for this cell's vertex block
+                            // each cache vertex used by an exposed face is stored once, and shared by all the cell's tris that touch it
+    vector<short> tri_verts; // (indexed mode only) 3 per tri (parallel to tri_inds), the tri's corners as indices into vert_inds
+    CellCache cache;
+};
+
+// backing store for CellCaches: each array holds many cells' data back to back, so computing a diagram makes a few big allocations
+// rather than three per cell, and cells computed together (e.g. a build, in cell order) sit together in memory.
+// Recomputed or deleted caches leave garbage behind, which compact() squeezes out once it's most of the arena
+struct CellArena {
+    vector<cache_face_int> faces;
+    vector<cache_real> vertices;
+    vector<int> neighbors;
+    size_t garbage; // entries that no cache uses anymore, over all three arrays
+    vector<int> tmp_faces, tmp_neighbors, tmp_vmap; // reused temp vars for voro++'s face_mesh (only ever grown)
+    vector<double> tmp_vertices;
+    
+    CellArena() : garbage(0) {}
+    
+    template<typename T, typename S> static void append(vector<T> &arr, const S *src, int len, ArenaSpan<T> &span) { // (converts S to T)
+        span.arr = &arr;
+        span.start = (int)arr.size();
+        span.len = len;
+        arr.insert(arr.end(), src, src+len);
+    }
+    void create(CellCache &cache, const glm::vec3 &pos, voro::voronoicell_neighbor &c) { // cache must be empty (see release)
+        assert(cache.faces.empty() && cache.vertices.empty() && cache.neighbors.empty());
+        int fv_len, nf, nv;
+        face_mesh(c, pos, fv_len, nf, nv);
+        append(neighbors, tmp_neighbors.data(), nf, cache.neighbors);
+        append(faces, tmp_faces.data(), fv_len, cache.faces);
+        append(vertices, tmp_vertices.data(), nv*3, cache.vertices);
+    }
+    // fills the tmp vectors in one pass over the cell: faces as (#verts in face 1, face vert ind 1, ind 2, ..., #vs in f 2, f v ind 1, etc),
+    // the neighbor across each face, and just the vertices that the faces use, numbered in the order the faces first reach them
+    void face_mesh(voro::voronoicell_neighbor &c, const glm::vec3 &pos, int &fv_len, int &nf, int &nv) {
+        int fv_size, f_size;
+        c.face_mesh_size(fv_size, f_size);
+        grow(tmp_faces, fv_size); grow(tmp_neighbors, f_size);
+        grow(tmp_vertices, c.p*3); grow(tmp_vmap, c.p);
+        c.face_mesh(pos.x, pos.y, pos.z, tmp_faces.data(), tmp_neighbors.data(), tmp_vertices.data(), tmp_vmap.data(), fv_len, nf, nv);
+    }
+    template<typename T> static void grow(vector<T> &v, int n) {
+        if ((int)v.size() < n) v.resize(n);
+    }
+    void release(CellCache &cache) {
+        garbage += cache.faces.size() + cache.vertices.size() + cache.neighbors.size();
+        cache = CellCache();
+    }
+    // moves a cache from another arena (e.g. a build thread's) to the end of this one
+    void take(CellCache &cache) {
+        CellCache from = cache;
+        append(neighbors, from.neighbors.data(), (int)from.neighbors.size(), cache.neighbors);
+        append(faces, from.faces.data(), (int)from.faces.size(), cache.faces);
+        append(vertices, from.vertices.data(), (int)from.vertices.size(), cache.vertices);
+    }
+    size_t size() const { return faces.size() + vertices.size() + neighbors.size(); }
+    bool wants_compact() const { return garbage > size()/2; }
+    // rewrites the arrays w/ just the live caches' data, in cell order
+    void compact(const vector<CellToTris*> &info) {
+        CellArena packed;
+        packed.faces.reserve(faces.size());
+        packed.vertices.reserve(vertices.size());
+        packed.neighbors.reserve(neighbors.size());
+        for (CellToTris *c2t : info) {
+            if (c2t) {
+                packed.take(c2t->cache);
+            }
+        }
+        faces.swap(packed.faces);
+        vertices.swap(packed.vertices);
+        neighbors.swap(packed.neighbors);
+        garbage = 0;
+        for (CellToTris *c2t : info) { // the spans now point into packed's arrays, which we just swapped into ours
+            if (c2t) {
+                c2t->cache.faces.arr = &faces;
+                c2t->cache.vertices.arr = &vertices;
+                c2t->cache.neighbors.arr = &neighbors;
+            }
+        }
+    }
+    void clear() {
+        faces.clear(); vertices.clear(); neighbors.clear();
+        garbage = 0;
+    }
+};
+
+// CellToTris are handed out from chunks of CELL_POOL_CHUNK and recycled through a free list, rather than new'd one at a time
+struct CellToTrisPool {
+    vector<CellToTris*> chunks, free_list;
+    
+    CellToTris *alloc() {
+        if (free_list.empty()) {
+            CellToTris *chunk = new CellToTris[CELL_POOL_CHUNK];
+            chunks.push_back(chunk);
+            for (int i=CELL_POOL_CHUNK-1; i>=0; i--) {
+                free_list.push_back(chunk+i);
+            }
+        }
+        CellToTris *c2t = free_list.back();
+        free_list.pop_back();
+        return c2t;
+    }
+    void release(CellToTris *c2t) { // c2t's tris and cache must already be released; its vectors keep their capacity for the next user
+        assert(c2t->tri_inds.empty() && c2t->vert_inds.empty() && c2t->cache.faces.empty());
+        free_list.push_back(c2t);
+    }
+    void clear() {
+        for (CellToTris *chunk : chunks) {
+            delete[] chunk;
+        }
+        chunks.clear();
+        free_list.clear();
+    }
+};
+
+// a [start, end) range of gl buffer entries written since the last clear, so the renderer only needs to re-upload that part
+struct GLRange {
+    int start, end;
+    
+    GLRange() : start(0), end(0) {}
+    GLRange(int start, int end) : start(start), end(end) {}
+    
+    bool empty() const { return start >= end; }
+    void add(int i) { add(i, i+1); }
+    void add(int s, int e) {
+        if (s >= e) return;
+        if (empty()) {
+            start = s; end = e;
+        } else {
+            start = min(start, s); end = max(end, e);
+        }
+    }
+    void clear() { start = end = 0; }
+};
+
+// the free slots ('holes') of a gl buffer, as a bitmap so we can quickly find the hole nearest to where we'd like to write
+struct BufferHoles {
+    vector<uint64_t> bits;
+    int count;
+    
+    BufferHoles() : count(0) {}
+    
+    void clear() { bits.clear(); count = 0; }
+    void add(int i) {
+        if (size_t(i/64) >= bits.size()) bits.resize(i/64+1, 0);
+        bits[i/64] |= uint64_t(1) << (i%64);
+        count++;
+    }
+    void remove(int i) {
+        bits[i/64] &= ~(uint64_t(1) << (i%64));
+        count--;
+    }
+    // returns (and removes) a hole within about max_words*64 slots of near, or -1 if there's none
+    int take_near(int near, int max_words) {
+        if (!count) return -1;
+        int w = max(0, min(near/64, int(bits.size())-1));
+        for (int d=0; d<=max_words; d++) {
+            if (w+d < int(bits.size()) && bits[w+d]) {
+                int i = (w+d)*64 + __builtin_ctzll(bits[w+d]);
+                remove(i);
+                return i;
+            }
+            if (d > 0 && w-d >= 0 && bits[w-d]) {
+                int i = (w-d)*64 + 63 - __builtin_clzll(bits[w-d]);
+                remove(i);
+                return i;
+            }
+        }
+        return -1;
+    }
+    void list(vector<int> &holes) const { // all holes, in increasing order
+        holes.clear();
+        for (size_t wi=0; wi<bits.size(); wi++) {
+            for (uint64_t b = bits[wi]; b; b &= b-1) {
+                holes.push_back(int(wi*64) + __builtin_ctzll(b));
+            }
+        }
+    }
+};
+
+struct Voro;
+struct CacheWorker;
+
+struct GLBufferManager {
+    vector<float> vertices, wire_vertices, cell_sites, cell_site_sizes, colors;
+    bool want_colors;
+    int tri_count, max_tris, max_sites;
+    int wire_vert_count, wire_max_verts;
+    vector<int> cell_inds; // map from tri indices to cell indices
+    vector<short> cell_internal_inds; // map from tri indices to internal tri backref
+    voro::voronoicell_neighbor_fixed<> vorocell; // reused temp var, holds computed cell info
+    int build_threads; // max threads to use for compute_all/compute_on; 0 means use all hardware threads
+    
+    vector<CellToTris*> info; // (allocated from cell_pool; their caches' data is in cache_arena)
+    CellToTrisPool cell_pool;
+    CellArena cache_arena;
+    
+    // in indexed mode, vertices/colors hold 3 floats per vertex (appended a cell at a time) and indices holds 3 vertex indices per tri;
+    // otherwise vertices/colors hold 9 floats per tri.  Either way, tris are identified by their index in [0, tri_count)
+    bool indexed;
+    vector<uint32_t> indices;
+    int vert_count, max_verts; // (indexed mode only)
+    vector<int> vert_cells; // (indexed mode only) map from vertex indices to cell indices
+    vector<short> vert_internal_inds; // (indexed mode only) map from vertex indices to internal vertex backref
+    vector<int> vert_slots; // reused temp var, maps the cache vertices of the cell being added to its vert_inds
+    vector<int> moved_vert_cells; // reused temp var, cells whose vertices were moved while compacting the vertex buffer
+    
+    // clearing a cell's tris leaves holes (degenerate tris w/ cell_inds -1), rather than moving the last tris into them; add_tri then
+    // reuses the hole nearest to tri_hint (set to a neighbor's tris by add_cell_tris), so an edit only rewrites a small stretch of the
+    // buffer and dirty_tris stays small.  Once holes make up a good part of the buffer, compact_holes() moves the last tris into them.
+    // The same goes for the vertices, in indexed mode
+    BufferHoles tri_holes, vert_holes;
+    int tri_hint, vert_hint;
+    bool building; // set by add_tris_in_block_order, which appends everything and leaves its slack holes for later edits
+    vector<int> hole_list; // reused temp var for compact_holes
+    GLRange dirty_tris, dirty_verts, dirty_sites; // what's changed since the last clear_dirty (dirty_verts is only tracked in indexed mode)
+    
+    // edits don't recompute anything right away; they mark the affected cells dirty, and flush() then recomputes each one once
+    enum {
+        DIRTY_GEOM = 1,     // recompute the cell (cache + tris)
+        DIRTY_TRIS = 2,     // just re-add the cell's tris (a neighbor's type changed)
+        DIRTY_NBR_GEOM = 4, // after recomputing, also recompute the neighbors it has then (the cell moved or is new)
+        DIRTY_NBR_TRIS = 8, // after recomputing, also re-add the tris of the neighbors it has then (the cell's type changed)
+        DIRTY_DONE = 16     // already recomputed in the current flush
+    };
+    vector<unsigned char> dirty_flags; // DIRTY_* flags per cell, parallel to info
+    vector<int> dirty_cells; // the cells w/ nonzero dirty_flags
+    
+    // a cell that didn't move itself can be re-cut from a candidate list instead of searched for in the container: its old neighbors,
+    // the old neighbors of any moved cell among those (removing a site only joins cells that were its neighbors), and the moved or new
+    // cells that now list it as a neighbor.  That's only exact while the caches all describe the diagram as of the last flush
+    bool recut_blocked; // set when they might not (a delete, or a cache computed between flushes); cleared by flush
+    unordered_map<int, pair<int,int>> recut_old_span; // moved cell -> (start, len) of its pre-flush neighbors in recut_old_nbrs; len -1 if unknown
+    vector<int> recut_old_nbrs;
+    vector<pair<int,int>> recut_new_adj; // sorted (neighbor, cell) pairs from the moved/new cells' recomputed neighbor lists
+    vector<int> recut_ids, recut_stamp; // reused temp vars for recut_cell
+    vector<int> cut_ijk, cut_q; // reused temp vars, container positions of the cells to cut w/ (in recut_cell, or as compute_cell's seeds)
+    int recut_pass;
+    
+    GLBufferManager() : wire_vert_count(0), wire_max_verts(0), tri_count(0), max_tris(0), cell_inds(0), want_colors(false), build_threads(0),
+                        indexed(false), vert_count(0), max_verts(0), tri_hint(0), vert_hint(0), building(false),
+                        recut_blocked(false), recut_pass(0) {}
+    
+    explicit operator bool() { return !info.empty(); }
+    
+    bool sanity(string when, bool doassert=true) {
+        bool valid = true;
+        if (vertices.size() != colors.size() && want_colors) {
+            valid = false;
+            cout << "want vertex colors, but they're not matched to vertices" << endl;
+        }
+        if (!colors.empty() && !want_colors) {
+            valid = false;
+            cout << "don't want vertex colors, but somehow we still have " << colors.size() << " of them" << endl;
+        }
+        int holes = 0;
+        for (int ci=0; ci<tri_count; ci++) {
+            if (cell_inds[ci] == -1) {
+                holes++;
+                continue;
+            }
+            if (cell_inds[ci] < 0 || cell_inds[ci] >= info.size()) {
+                valid = false;
+                cout << "invalid cell! " << cell_inds[ci] << " vs " << info.size() << endl;
+            }
+            for (int ii=0; indexed && ii<3; ii++) {
+                uint32_t vi = indices[ci*3+ii];
+                if (vi >= uint32_t(vert_count) || vert_cells[vi] != cell_inds[ci]) {
+                    valid = false;
+                    cout << "tri " << ci << " of cell " << cell_inds[ci] << " has invalid vertex index " << vi << " vs " << vert_count << endl;
+                }
+            }
+        }
+        if (holes != tri_holes.count) {
+            valid = false;
+            cout << "tri holes mismatch the hole bitmap: " << holes << " vs " << tri_holes.count << endl;
+        }
+        for (int i=0; i<info.size(); i++) {
+            if (info[i]) {
+                for (int ti : info[i]->tri_inds) {
+                    if (cell_inds[ti] != i) {
+                        valid = false;
+                        cout << "invalid backlink " << cell_inds[ti] << " vs " << i << endl;
+                    }
+                }
+                for (int vi : info[i]->vert_inds) {
+                    if (vert_cells[vi] != i) {
+                        valid = false;
+                        cout << "invalid vertex backlink " << vert_cells[vi] << " vs " << i << endl;
+                    }
+                }
+                for (size_t nii=0; nii<info[i]->cache.neighbors.size(); nii++) {//(int ni : info[i]->cache.neighbors) {
+                    int ni = info[i]->cache.neighbors[nii];
+                    if (ni >= int(info.size())) {
+                        valid = false;
+                        cout << "neighbor index is out of bounds: " << i << ": " << ni << " vs " << info.size() << endl;
+                    }
+                    if (ni >= 0 && ni < int(info.size()) && info[ni]) {
+                        bool backlink = false;
+                        for (int nni : info[ni]->cache.neighbors) {
+                            if (nni == i) {
+                                backlink = true;
+                            }
+                        }
+                        if (!backlink) {
+                            cout << "neighbor " << i << " -> " << ni << " lacks backlink" << endl;
+                            double face_area = info[i]->cache.face_size(nii);
+                            if (face_area < 4.84704e-14) {
+                                cout << "backlink error on face so small (" << face_area  << ") so maybe we don't care?" << endl;
+                            } else {
+                                valid = false;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        
+        if (!valid) {
+            cout << "invalid " << when << endl;
+        }
+        
+        assert(!doassert || valid);
+        
+        return valid;
+    }
+    
+    void resize_buffers() {
+        if (indexed) {
+            vertices.resize(max_verts*3);
+            vert_cells.resize(max_verts);
+            vert_internal_inds.resize(max_verts);
+            indices.resize(max_tris*3);
+        } else {
+            vertices.resize(max_tris*9);
+        }
+        cell_inds.resize(max_tris);
+        cell_internal_inds.resize(max_tris);
+        if (want_colors) {
+            colors.resize(vertices.size());
+        }
+    }
+    void resize_wire_buffers() {
+        wire_vertices.resize(wire_max_verts*3);
+    }
+    void resize_sites_buffers() {
+        cell_sites.resize(max_sites*3);
+        cell_site_sizes.resize(max_sites);
+    }
+    void set_want_colors(Voro &src, bool yes_colors); // call to change whether you want colors
+    void update_colors(Voro &src); // call whenever the palette changes to fix all existing colors
+    
+    void init(int numCells, int triCapacity, int wiresCapacity, int sitesCapacity, bool want_colors) {
+        clear();
+        
+        this->want_colors = want_colors;
+        max_tris = triCapacity;
+        max_verts = indexed ? triCapacity/2+3 : 0; // exposed faces are mostly closed surfaces, which have about half as many vertices as tris
+        wire_max_verts = wiresCapacity;
+        max_sites = numCells*2;
+        if (max_sites < sitesCapacity) max_sites = sitesCapacity;
+        
+        resize_buffers();
+        resize_wire_buffers();
+        resize_sites_buffers();
+        tri_count = 0;
+        vert_count = 0;
+        wire_vert_count = 0;
+        clear_dirty();
+        
+        info.resize(numCells, 0);
+        dirty_flags.resize(numCells, 0);
+    }
+    
+    void add_cell(Voro &src);
+    
+    // vi indexes the drawn vertex stream, i.e. it's tri*3+corner in either mode (the index of the vertex in gl_indices, when indexed)
+    int vert2cell(int vi) {
+        if (vi < 0 || vi >= tri_count*3)
+            return -1;
+        return cell_inds[vi/3];
+    }
+    int vert2cell_neighbor(int vi) {
+        if (vi < 0 || vi >= tri_count*3) return -1;
+        int tri = vi / 3;
+        int cell = cell_inds[tri];
+        if (cell < 0) return -1;
+        CellToTris *in = info[cell];
+        if (!in) return -1;
+        int fi = in->tri_faces[cell_internal_inds[tri]];
+        return in->cache.neighbors[fi];
+    }
+    
+    inline void clear_cell_tris(CellToTris &c2t) {
+        for (int tri : c2t.tri_inds) {
+            release_tri(tri);
+        }
+        c2t.tri_inds.clear();
+        c2t.tri_faces.clear();
+        c2t.tri_verts.clear();
+        for (int vi : c2t.vert_inds) {
+            release_vert(vi);
+        }
+        c2t.vert_inds.clear();
+    }
+    inline void clear_cell_cache(CellToTris &c2t) {
+        cache_arena.release(c2t.cache);
+    }
+    inline void clear_cell_all(CellToTris &c2t) {
+        clear_cell_tris(c2t);
+        clear_cell_cache(c2t);
+    }
+    
+    inline CellToTris& get_clean_cell(int cell) {
+        if (!info[cell]) {
+            info[cell] = cell_pool.alloc();
+        } else {
+            clear_cell_all(*info[cell]);
+        }
+        return *info[cell];
+    }
+    
+    inline void mark_dirty(int cell, int flags) {
+        if (cell < 0 || cell >= int(info.size())) return; // neighbor lists can briefly hold stale indices after a delete; those cells are dirty anyway
+        if (!dirty_flags[cell]) dirty_cells.push_back(cell);
+        dirty_flags[cell] |= flags;
+    }
+    inline void mark_neighbors_dirty(int cell, int flags) {
+        if (!info[cell]) return;
+        for (int ni : info[cell]->cache.neighbors) {
+            mark_dirty(ni, flags);
+        }
+    }
+    void flush(Voro &src); // recompute everything that's been marked dirty since the last flush
+    
+    CellCache *get_cache(int cell) {
+        if (cell < 0 || cell >= info.size() || !info[cell]) {
+            return 0;
+        }
+        return &info[cell]->cache;
+    }
+    
+    
+    inline bool add_tri(const cache_real *input_v, int* vs, int cell, CellToTris &c2t, int f, const glm::vec3 &color) {
+        int tri = building ? -1 : tri_holes.take_near(tri_hint, HOLE_SEARCH_WORDS);
+        if (tri < 0) {
+            if (tri_count+1 >= max_tris) {
+                max_tris *= 2;
+                resize_buffers();
+            }
+            tri = tri_count++;
+        }
+        
+        if (indexed) {
+            for (int vii=0; vii<3; vii++) {
+                int &vert = vert_slots[vs[vii]];
+                if (vert < 0) {
+                    vert = (int)c2t.vert_inds.size();
+                    add_vert(input_v, vs[vii], cell, c2t, color);
+                }
+                indices[tri*3+vii] = c2t.vert_inds[vert];
+                c2t.tri_verts.push_back((short)vert);
+            }
+        } else {
+            float *v = &vertices[0] + tri*9;
+            for (int vii=0; vii<3; vii++) {
+                int ibase = vs[vii]*3;
+                for (int ii=0; ii<3; ii++) {
+                    *v = input_v[ibase+ii];
+                    v++;
+                }
+            }
+        }
+        if (want_colors && !indexed) {
+            assert(vertices.size() == colors.size());
+            float *c = &colors[0] + tri*9;
+            for (int vii=0; vii<3; vii++) {
+                int ibase = vs[vii]*3;
+                for (int ii=0; ii<3; ii++) {
+                    *c = color[ii];
+                    c++;
+                }
+            }
+        }
+        cell_inds[tri] = cell;
+        cell_internal_inds[tri] = (short)c2t.tri_inds.size();
+        c2t.tri_inds.push_back(tri);
+        c2t.tri_faces.push_back(f);
+        dirty_tris.add(tri);
+        tri_hint = tri;
+        
+        return true;
+    }
+    inline void add_vert(const cache_real *input_v, int vi, int cell, CellToTris &c2t, const glm::vec3 &color) {
+        int slot = building ? -1 : vert_holes.take_near(vert_hint, HOLE_SEARCH_WORDS);
+        if (slot < 0) {
+            if (vert_count+1 >= max_verts) {
+                max_verts *= 2;
+                resize_buffers();
+            }
+            slot = vert_count++;
+        }
+        
+        float *v = &vertices[0] + slot*3;
+        for (int ii=0; ii<3; ii++) {
+            v[ii] = input_v[vi*3+ii];
+        }
+        if (want_colors) {
+            assert(vertices.size() == colors.size());
+            float *c = &colors[0] + slot*3;
+            for (int ii=0; ii<3; ii++) {
+                c[ii] = color[ii];
+            }
+        }
+        vert_cells[slot] = cell;
+        vert_internal_inds[slot] = (short)c2t.vert_inds.size();
+        c2t.vert_inds.push_back(slot);
+        dirty_verts.add(slot);
+        vert_hint = slot;
+    }
+    inline void release_tri(int tri) {
+        if (indexed) {
+            indices[tri*3] = indices[tri*3+1] = indices[tri*3+2] = 0;
+        } else {
+            fill(vertices.begin()+tri*9, vertices.begin()+tri*9+9, 0.0f);
+        }
+        cell_inds[tri] = -1;
+        tri_holes.add(tri);
+        dirty_tris.add(tri);
+    }
+    inline void release_vert(int vi) { // no tri refers to it anymore, so its data can be left as-is
+        vert_cells[vi] = -1;
+        vert_holes.add(vi);
+    }
+    void add_slack(int n) { // appends n holes to the tri (and, if indexed, vert) buffers
+        if (tri_count+n >= max_tris || (indexed && vert_count+n >= max_verts)) {
+            while (tri_count+n >= max_tris) max_tris *= 2;
+            while (indexed && vert_count+n >= max_verts) max_verts *= 2;
+            resize_buffers();
+        }
+        for (int i=0; i<n; i++) {
+            release_tri(tri_count++);
+            if (indexed) {
+                release_vert(vert_count++);
+            }
+        }
+    }
+    
+    void set_cell(Voro &src, int cell, int oldtype);
+    
+    void compute_cell(Voro &src, int cell); // compute caches for all cells and add tris for non-zero cells
+    bool recut_cell(Voro &src, int cell); // flush's fast path for compute_cell; false if it can't vouch for the result (nothing changed then)
+
+    void compute_all(Voro &src, int tricap, int wirecap, int sitescap, bool want_colors);
+    void compute_on(Voro &src, int tricap, int wirecap, int sitescap, bool want_colors);
+    // computes just the caches (no tris) for the given not-yet-computed cells, spread across threads;
+    // each worker has its own voro_compute scratch + vorocell and only writes the info[] entries of its own cells
+    void compute_caches(Voro &src, const vector<int> &cells);
+    void compute_caches_range(Voro &src, const vector<int> &cells, CacheWorker &w, size_t start, size_t end);
+    
+    void add_cell_tris(Voro &src, int cell, CellToTris &c2t);
+    void add_tris_in_block_order(Voro &src);
+   
+    void move_tri(int from, int to) {
+        if (indexed) {
+            for (int ii=0; ii<3; ii++) {
+                indices[to*3+ii] = indices[from*3+ii];
+            }
+        } else {
+            for (int ii=0; ii<9; ii++) {
+                vertices[to*9+ii] = vertices[from*9+ii];
+            }
+        }
+        if (want_colors && !indexed) {
+            assert(vertices.size() == colors.size());
+            for (int ii=0; ii<9; ii++) {
+                colors[to*9+ii] = colors[from*9+ii];
+            }
+        }
+        cell_inds[to] = cell_inds[from];
+        cell_internal_inds[to] = cell_internal_inds[from];
+        info[cell_inds[to]]->tri_inds[cell_internal_inds[to]] = to;
+    }
+    void move_vert(int from, int to) {
+        for (int ii=0; ii<3; ii++) {
+            vertices[to*3+ii] = vertices[from*3+ii];
+        }
+        if (want_colors) {
+            for (int ii=0; ii<3; ii++) {
+                colors[to*3+ii] = colors[from*3+ii];
+            }
+        }
+        vert_cells[to] = vert_cells[from];
+        vert_internal_inds[to] = vert_internal_inds[from];
+        info[vert_cells[to]]->vert_inds[vert_internal_inds[to]] = to;
+        moved_vert_cells.push_back(vert_cells[to]); // its tris' indices are stale until update_cell_indices
+    }
+    // fills the holes w/ the last tris (or verts), so the buffer is dense again; returns the new count
+    template<typename MoveFn> int fill_holes(BufferHoles &buffer_holes, const vector<int> &owners, int count, GLRange &dirty, MoveFn move) {
+        if (!buffer_holes.count) return count;
+        vector<int> &holes = hole_list;
+        buffer_holes.list(holes);
+        buffer_holes.clear();
+        int end = count, live = count - int(holes.size());
+        for (int hole : holes) {
+            while (end > hole && owners[end-1] < 0) end--; // skip holes at the end
+            if (end <= hole) break;
+            end--;
+            move(end, hole);
+        }
+        dirty.add(holes.front(), live);
+        return live;
+    }
+    void compact_holes() {
+        if (tri_holes.count > tri_count/4) {
+            tri_count = fill_holes(tri_holes, cell_inds, tri_count, dirty_tris, [this](int from, int to) { move_tri(from, to); });
+        }
+        if (indexed && vert_holes.count > vert_count/4) {
+            moved_vert_cells.clear();
+            vert_count = fill_holes(vert_holes, vert_cells, vert_count, dirty_verts, [this](int from, int to) { move_vert(from, to); });
+            // the moved vertices mostly come from the few cells at the end of the buffer, so fix up each of those cells' indices just once
+            sort(moved_vert_cells.begin(), moved_vert_cells.end());
+            moved_vert_cells.erase(unique(moved_vert_cells.begin(), moved_vert_cells.end()), moved_vert_cells.end());
+            for (int cell : moved_vert_cells) {
+                update_cell_indices(*info[cell]);
+            }
+        }
+    }
+    void update_cell_indices(CellToTris &c2t) {
+        for (size_t i=0; i<c2t.tri_inds.size(); i++) {
+            for (int ii=0; ii<3; ii++) {
+                indices[c2t.tri_inds[i]*3+ii] = c2t.vert_inds[c2t.tri_verts[i*3+ii]];
+            }
+            dirty_tris.add(c2t.tri_inds[i]);
+        }
+    }
+    void clear_dirty() {
+        dirty_tris.clear();
+        dirty_verts.clear();
+        dirty_sites.clear();
+    }
+    
+    void ensure_computed(Voro &src, int cell); // if src is ready to compute things, ensures that the cell is computed
+    
+    void swapnpop_cell(Voro &src, int cell, int lasti);
+    void renumber_cells(Voro &src, const vector<int> &new_index); // cell i becomes new_index[i]; call after src has renumbered its cells
+    void move_cell(Voro &src, int cell);
+    void move_cells(Voro &src, const unordered_set<int> &cells);
+    
+    void update_site(Voro &src, int cell);
+    inline void update_site_pos(const glm::vec3 &pos, int cell) {
+        assert(cell >= 0 && cell < cell_sites.size());
+        cell_sites[cell*3]   = pos.x;
+        cell_sites[cell*3+1] = pos.y;
+        cell_sites[cell*3+2] = pos.z;
+        dirty_sites.add(cell);
+    }
+    inline void update_site_size(float size, int cell) {
+        cell_site_sizes[cell] = size;
+        dirty_sites.add(cell);
+    }
+    
+    void add_wires(Voro &src, int cell);
+    inline void add_wire_vert(const ArenaSpan<cache_real> &vertices, int vi) {
+        assert(vi*3+2 < vertices.size());
+        if (wire_vert_count >= wire_max_verts) {
+            wire_max_verts *= 2;
+            resize_wire_buffers();
+        }
+        float *buf = &wire_vertices[0] + (wire_vert_count*3);
+
+        *buf = vertices[vi*3]; buf++;
+        *buf = vertices[vi*3+1]; buf++;
+        *buf = vertices[vi*3+2]; buf++;
+        wire_vert_count++;
+    }
+    void clear_wires() {
+        wire_vert_count = 0;
+    }
+    
+    void clear() {
+        vertices.clear();
+        indices.clear();
+        vert_cells.clear();
+        vert_internal_inds.clear();
+        cell_inds.clear();
+        wire_vertices.clear();
+        cell_sites.clear();
+        cell_site_sizes.clear();
+        colors.clear();
+        
+        tri_count = max_tris = max_sites = 0;
+        vert_count = max_verts = 0;
+        tri_holes.clear();
+        vert_holes.clear();
+        clear_dirty();
+        
+        info.clear();
+        cell_pool.clear();
+        cache_arena.clear();
+        dirty_flags.clear();
+        dirty_cells.clear();
+        recut_blocked = false;
+    }
+};
+
+// simple index mesh struct, to be used for export to an index mesh format
+struct SimpleIndexMesh {
+    std::vector<int> faces; // voro-style face list: [size1, v1, v2, v3, ..., vSize, size2, etc]
+    std::vector<int> palette; // palette index per face
+	std::vector<double> vertices;
+};
+
+
+enum { SANITY_MINIMAL, SANITY_FULL, SANITY_EXCESSIVE };
+
+struct Voro {
+    Voro()
+        : b_min(glm::vec3(-10)), b_max(glm::vec3(10)), con(0), regrid_at(0), sanity_level(SANITY_FULL), tracked_ids(0), unsorted_cells(0) {}
+    Voro(glm::vec3 bound_min, glm::vec3 bound_max)
+        : b_min(bound_min), b_max(bound_max), con(0), regrid_at(0), sanity_level(SANITY_FULL), tracked_ids(0), unsorted_cells(0) {}
+    ~Voro() {
+        clear_all();
+    }
+    
+    template<typename T> bool compare_vecs(vector<T> a, vector<T> b, string name, int tag) {
+        sort(a.begin(), a.end());
+        sort(b.begin(), b.end());
+        if (!equal(a.begin(), a.end(), b.begin())) {
+            cout << name << " mismatched on " << tag << endl << "F: ";
+            for (const auto &i: a)
+                cout << i << ' ';
+            cout << endl << "T: ";
+            for (const auto &i: b)
+                cout << i << ' ';
+            cout << endl;
+            return false;
+        } else {
+            return true;
+        }
+    }
+    
+    bool sanity(string when) {
+        gl_flush();
+        bool valid = true;
+        
+        if (sanity_level > 0) {
+            valid = gl_computed.sanity(when, false);
+        }
+        for (int cell=0; cell<links.size(); cell++) {
+            const auto &link = links[cell];
+            if (link.ijk >= 0 && link.q < 0) {
+                cout << "partially valid link " << cell << ": " << link.ijk << " " << link.q << endl;
+                valid = false;
+            }
+        }
+        if (sanity_level > 0) {
+            if (gl_computed.info.size() > 0) {
+                if (gl_computed.info.size() != cells.size()) {
+                    cout << "computed info cells mismatch voro cells: " << gl_computed.info.size() << " vs " << cells.size() << endl;
+                    valid = false;
+                }
+                CellArena arena;
+                for (int i=0; i<cells.size(); i++) {
+                    CellCache cache;
+                    arena.clear();
+                    if (gl_computed.info[i]) {
+                        auto &link = links[i];
+                        if (link.valid()) {
+                            if (con->compute_cell(gl_computed.vorocell, link.ijk, link.q)) {
+                                arena.create(cache, cells[i].pos, gl_computed.vorocell);
+                                auto &vs = gl_computed.info[i]->cache;
+                                valid = compare_vecs(vs.neighbors.to_vector(), cache.neighbors.to_vector(), "neighbors", i) && valid;
+//                                bool fvalid = compare_vecs(vs.faces.to_vector(), cache.faces.to_vector(), "faces", i);
+//                                valid = fvalid && valid;
+//                                valid = compare_vecs(vs.vertices.to_vector(), cache.vertices.to_vector(), "vertices", i) && valid;
+                            }
+                        }
+                    }
+                }
+                if (sanity_level > 1) {
+                    // Use a pre_container to automatically figure out the right settings for the container we create
+                    voro::pre_container pcon(b_min.x,b_max.x,b_min.y,b_max.y,b_min.z,b_max.z,false,false,false);
+                    
+                    {
+                        // iterating through particles && try to match order in the blocks to guarantee same numerical result
+                        voro::c_loop_all vl(*con);
+                        if (vl.start()) do {
+                            int i = vl.pid();
+                            pcon.put(i,cells[i].pos.x,cells[i].pos.y,cells[i].pos.z);
+                        } while(vl.inc());
+                    }
+                    
+                    // Set up the number of blocks that the container is divided into
+                    int n_x, n_y, n_z;
+                    pcon.guess_optimal(n_x,n_y,n_z);
+                    
+                    // Set up the container class and import the particles from the pre-container
+                    voro::container dcon(pcon.ax,pcon.bx,pcon.ay,pcon.by,pcon.az,pcon.bz,n_x,n_y,n_z,false,false,false,10);
+                    pcon.setup(dcon);
+                    
+                    // build links
+                    voro::c_loop_all vl(dcon);
+                    voro::voronoicell_neighbor vorocell;
+                    if(vl.start()) do {
+                        int i = vl.pid();
+                        if (dcon.compute_cell(vorocell, vl.ijk, vl.q)) {
+                            CellCache cache;
+                            arena.clear();
+                            arena.create(cache, cells[i].pos, vorocell);
+                            if (gl_computed.info[i]) {
+                                auto &vs = gl_computed.info[i]->cache;
+                                bool nvalid = compare_vecs(vs.neighbors.to_vector(), cache.neighbors.to_vector(), " full-recon neighbors", i);
+                                bool fvalid = compare_vecs(vs.faces.to_vector(), cache.faces.to_vector(), " full-recon faces", i);
+                                valid = valid && nvalid && fvalid;
+                                if (!nvalid || !fvalid) {
+                                    cout << "cell[" << i << "].pos = " << cells[i].pos.x << ", " << cells[i].pos.y << ", " << cells[i].pos.z << endl;
+                                }
+                            } else {
+                                cout << "no info for valid cell?" << endl;
+                                valid = false;
+                            }
+                        }
+                        
+                    } while(vl.inc());
+                }
+            }
+        }
+        
+        if (!valid) {
+            cout << "sanity check on Voro failed: " << when << endl;
+        }
+        assert(valid);
+        return valid;
+    }
+    
+    void clear_all() {
+        clear_computed();
+        clear_input();
+    }
+    
+    // clears the input from which the voronoi diagram would be build (the point set)
+    void clear_input() {
+        cells.clear();
+        unsorted_cells = 0;
+    }
+    
+    // clears out just the buffers + cached cell computations used for rendering
+    void clear_gl() {
+        gl_computed.clear();
+    }
+    
+    // clears out all computed structures of the voronoi diagram.
+    void clear_computed() {
+        delete con; con = 0;
+        links.clear();
+        gl_computed.clear();
+    }
+    
+    void set_only_centermost(int centermost_type, int other_type) {
+        if (cells.empty()) return;
+        int minc = 0;
+        double minl = glm::length2(cells[0].pos);
+        set_cell(0, other_type);
+        for (size_t i=1; i<cells.size(); i++) {
+            double pl = glm::length2(cells[i].pos);
+            if (pl < minl) {
+                minc = i;
+                minl = pl;
+            }
+            set_cell(i, other_type);
+        }
+        set_cell(minc, centermost_type);
+    }
+    
+    void set_all(int type) {
+        for (size_t i=0; i<cells.size(); i++) {
+            set_cell(i, type);
+        }
+    }
+    
+    void set_fill(double target_fill, int rand_seed) {
+        if (cells.empty()) return;
+        srand(rand_seed);
+        
+        if (target_fill <= 0 || target_fill >= 1) {
+            set_all(target_fill >= 1);
+            return;
+        }
+        
+        float fill = get_fill();
+        float newfill = fill;
+        const float one_cell_fill = (1.0/float(cells.size()));
+        int needs_more_fill = fill < target_fill;
+        while (needs_more_fill == (newfill < target_fill)) {
+            int ci = rand() % cells.size();
+            if ((!cells[ci].type) == needs_more_fill) {
+                set_cell(ci, needs_more_fill);
+                newfill = newfill + (2*needs_more_fill-1)*one_cell_fill;
+            }
+        }
+    }
+    
+    float get_fill() {
+        int nonz = 0;
+        for (size_t i=0; i<cells.size(); i++) {
+            nonz += !!cells[i].type;
+        }
+        return float(nonz) / float(cells.size());
+    }
+    
+    // creates an empty container w/ a block grid sized so that num_cells cells would be ~voro::optimal_particles per block
+    voro::container *new_container(size_t num_cells) {
+        auto d = b_max-b_min;
+        float ilscale = pow(double(num_cells)/(voro::optimal_particles*d.x*d.y*d.z),1.0/3.0);
+        auto n = d*ilscale;
+        voro::container *c = new voro::container(b_min.x,b_max.x,b_min.y,b_max.y,b_min.z,b_max.z,int(n.x+1),int(n.y+1),int(n.z+1),false,false,false,10);
+        regrid_at = size_t(c->nxyz*voro::optimal_particles*REGRID_FACTOR);
+        return c;
+    }
+    
+    // assuming cells vector is already created, now create the container for holding the cells
+    void build_container() {
+        clear_computed(); // clear out any existing computation
+        
+        con = new_container(cells.size());
+        
+        // build links
+        assert(links.size() == 0);
+        links.resize(cells.size());
+        put_cells(0, int(cells.size()));
+    }
+    
+    // puts cells [first,first+len) into the container, jittering any that collide
+    void put_cells(int first, int len) {
+        assert(con && links.size() == cells.size());
+        for (int i=first; i<first+len; i++) {
+            auto &link = links[i];
+            auto &pt = cells[i].pos;
+            while (con->already_in_container(pt.x, pt.y, pt.z, SHADOW_THRESHOLD) >= 0) {
+                jitter(pt, SHADOW_SEP_DIST);
+            }
+            bool ret = con->put(i, pt.x, pt.y, pt.z, link.ijk, link.q);
+            if (!ret) { link = CellConLink(); } // reset link if put fails
+        }
+    }
+    
+    // moves all cells into a new container w/ a grid sized for the current cell count, updating links to match.
+    // the diagram itself doesn't change, so the gl buffers and cell caches stay valid.
+    void regrid_container() {
+        assert(con && links.size() == cells.size());
+        voro::container *old = con;
+        con = new_container(cells.size());
+        for (int i=0; i<cells.size(); i++) {
+            auto &link = links[i];
+            if (!link.valid()) continue; // cell was outside the container before, and still is
+            const auto &pt = cells[i].pos;
+            bool ret = con->put(i, pt.x, pt.y, pt.z, link.ijk, link.q);
+            if (!ret) { link = CellConLink(); }
+        }
+        delete old;
+    }
+    
+    int cell_at_pos(glm::vec3 pt) {
+        assert(con);
+        return con->already_in_container(pt.x, pt.y, pt.z, SHADOW_THRESHOLD);
+    }
+    
+    int add_cell(glm::vec3 pt, int type) {
+        while (con && con->already_in_container(pt.x, pt.y, pt.z, SHADOW_THRESHOLD) >= 0) {
+            jitter(pt, SHADOW_SEP_DIST);
+        }
+        int id = int(cells.size());
+        
+        cells.push_back(Cell(pt, type));
+        if (con) {
+            CellConLink link;
+            bool ret = con->put(id, pt.x, pt.y, pt.z, link.ijk, link.q);
+            if (!ret) { link = CellConLink(); } // reset to invalid default when put fails
+            links.push_back(link);
+            assert(cells.size() == links.size());
+            
+            if (cells.size() > regrid_at) { // blocks are getting too crowded for fast compute_cell calls
+                regrid_container();
+            }
+            
+            gl_computed.add_cell(*this);
+        }
+        SANITY("after add_cell");
+        unsorted_cells++;
+        return id;
+    }
+    
+#ifdef EMSCRIPTEN
+    // js passes a Float32Array of xyz triples and an Int32Array of types; each is copied into the heap in one go
+    int add_cells(val posns, val types) {
+        int len = types["length"].as<int>();
+        vector<float> pos_list(len*3);
+        vector<int> type_list(len);
+        val(typed_memory_view(pos_list.size(), pos_list.data())).call<void>("set", posns);
+        val(typed_memory_view(type_list.size(), type_list.data())).call<void>("set", types);
+        return add_cells(pos_list.data(), type_list.data(), len);
+    }
+#endif
+    // adds len cells at once (e.g. when loading a file), w/ ids first..first+len-1 in the order given; returns first.
+    // before the container exists this just records the cells, for build_container to put all at once.  otherwise the container
+    // is regridded at most once, and the gl buffers are either fully recomputed (in parallel) for a batch as big as the
+    // diagram, or the new cells are just marked for the next gl_flush.
+    int add_cells(const float *posns, const int *types, int len) {
+        int first = int(cells.size());
+        cells.reserve(first+len);
+        for (int i=0; i<len; i++) {
+            cells.push_back(Cell(glm::vec3(posns[i*3], posns[i*3+1], posns[i*3+2]), types[i]));
+        }
+        if (!con) {
+            unsorted_cells += len;
+            return first;
+        }
+        
+        links.resize(cells.size());
+        if (cells.size() > regrid_at) {
+            regrid_container();
+        }
+        put_cells(first, len);
+        
+        if (gl_computed) {
+            if (len >= first) {
+                gl_computed.compute_on(*this, gl_computed.max_tris, gl_computed.wire_max_verts, gl_computed.max_sites, has_colors());
+            } else {
+                for (int i=0; i<len; i++) {
+                    gl_computed.add_cell(*this);
+                }
+            }
+        }
+        SANITY("after add_cells");
+        unsorted_cells += len;
+        return first;
+    }
+    
+    void debug_print_block(int ijk, int q) {
+        if (con) {
+            con->print_block(ijk, q);
+        } else {
+            cout << "no con; cannot print any block yet!" << endl;
+        }
+    }
+    
+    bool move_cell(int cell, glm::vec3 pt) { // similar to a delete+add, but w/ no swapping and less recomputation
+        if (cell < 0 || cell >= cells.size()) {
+            cout << "move_cell called w/ invalid cell (index out of range): " << cell << endl;
+            return false;
+        }
+        while (con && con->already_in_container(pt.x, pt.y, pt.z, SHADOW_THRESHOLD, cell) >= 0) {
+            jitter(pt, SHADOW_SEP_DIST);
+        }
+        
+        gl_computed.ensure_computed(*this, cell);
+        
+        cells[cell].pos = pt;
+        
+        if (!links.empty()) {
+            assert(links.size() == cells.size());
+            if (con) {
+                int needsupdate_q;
+                int needsupdate = con->move(links[cell].ijk, links[cell].q, cell, pt.x, pt.y, pt.z, needsupdate_q);
+                if (needsupdate > -1) { // we updated q of this element, so we need to update external backrefs to reflect that
+                    links[needsupdate].q = needsupdate_q; // only updating q is ok, since the swapnpop won't change the ijk
+                } 
+            }
+
+            gl_computed.move_cell(*this, cell);
+        }
+        
+        
+        
+        SANITY("after move_cell");
+        return true;
+    }
+    void set_palette(const vector<glm::vec3> &p) {
+        gl_flush();
+        palette = p;
+        if (gl_computed) {
+            gl_computed.set_want_colors(*this, has_colors());
+        }
+    }
+#ifdef EMSCRIPTEN
+    void set_palette(val p) {
+        int len = p["length"].as<int>();
+        vector<glm::vec3> colors;
+        for (int i=0; i<len; i++) {
+            glm::vec3 color(p[i][0].as<float>(), p[i][1].as<float>(), p[i][2].as<float>());
+            colors.push_back(color);
+        }
+        set_palette(colors);
+    }
+    bool move_cells(val cells_to_move, val posns) {
+        int len = cells_to_move["length"].as<int>();
+        vector<int> cell_list(len);
+        vector<glm::vec3> pos_list(len);
+        for (int i=0; i<len; i++) {
+            cell_list[i] = cells_to_move[i].as<int>();
+            pos_list[i] = glm::vec3(posns[i][0].as<float>(), posns[i][1].as<float>(), posns[i][2].as<float>());
+        }
+        return move_cells(cell_list, pos_list);
+    }
+#endif
+    // staging buffers in the module heap: js asks for room for len values, writes them through Module.HEAP32/HEAPF32 at the returned
+    // address, and passes the address to the pointer+length overloads below, so a batch call crosses into the module once instead
+    // of reading each element back through emscripten::val.  a later js_ints/js_floats call may move the buffer.
+    uintptr_t js_ints(int len) {
+        if (js_int_stage.size() < size_t(len)) js_int_stage.resize(len);
+        return reinterpret_cast<uintptr_t>(js_int_stage.data());
+    }
+    uintptr_t js_floats(int len) {
+        if (js_float_stage.size() < size_t(len)) js_float_stage.resize(len);
+        return reinterpret_cast<uintptr_t>(js_float_stage.data());
+    }
+    // colors points at len rgb triples
+    void set_palette(uintptr_t colors, int len) {
+        const float *c = reinterpret_cast<const float*>(colors);
+        vector<glm::vec3> pal(len);
+        for (int i=0; i<len; i++) {
+            pal[i] = glm::vec3(c[i*3], c[i*3+1], c[i*3+2]);
+        }
+        set_palette(pal);
+    }
+    // cells_to_move points at len cell indices, and posns at len xyz triples
+    bool move_cells(uintptr_t cells_to_move, uintptr_t posns, int len) {
+        return move_cells(reinterpret_cast<const int*>(cells_to_move), reinterpret_cast<const glm::vec3*>(posns), len);
+    }
+    bool move_cells(const vector<int> &cells_to_move, const vector<glm::vec3> &posns) {
+        assert(posns.size() == cells_to_move.size());
+        return move_cells(cells_to_move.data(), posns.data(), int(cells_to_move.size()));
+    }
+    bool move_cells(const int *cells_to_move, const glm::vec3 *posns, int len) { // similar to a delete+add, but w/ no swapping and less recomputation'
+        unordered_set<int> moved_cells;
+        for (int i=0; i<len; i++) {
+            int cell = cells_to_move[i];
+            if (cell < 0 || cell >= cells.size()) {
+                cout << "move_cell called w/ invalid cell (index out of range): " << cell << endl;
+                continue;
+            }
+            
+            gl_computed.ensure_computed(*this, cell);
+            
+            glm::vec3 pt = posns[i];
+            while (con && con->already_in_container(pt.x, pt.y, pt.z, SHADOW_THRESHOLD, cell) >= 0) {
+                jitter(pt, SHADOW_SEP_DIST);
+            }
+            
+            cells[cell].pos = pt;
+            moved_cells.insert(cell);
+            if (!links.empty()) {
+                assert(links.size() == cells.size());
+                if (con) {
+                    int needsupdate_q;
+                    int needsupdate = con->move(links[cell].ijk, links[cell].q, cell, pt.x, pt.y, pt.z, needsupdate_q);
+                    if (needsupdate > -1) { // we updated q of this element, so we need to update external backrefs to reflect that
+                        links[needsupdate].q = needsupdate_q; // only updating q is ok, since the swapnpop won't change the ijk
+                    }
+                }
+            }
+        }
+        
+        gl_computed.move_cells(*this, moved_cells);
+        
+        SANITY("after move_cells");
+        return true;
+    }
+    
+    bool delete_cell(int cell) { // this is a swapnpop deletion
+        if (cell < 0 || cell >= cells.size()) { // can't delete out of range
+            cout << "trying to delete out of range " << cell << " vs " << cells.size() << endl;
+            return false;
+        }
+        
+        int end_ind = int(cells.size())-1;
+        
+        // if we're deleting a cell that wasn't computed, but we've built links and all, compute it so we have valid nbr info there
+        gl_computed.ensure_computed(*this, cell);
+        if (end_ind != cell) {
+            gl_computed.ensure_computed(*this, end_ind);
+        }
+        
+        cells[cell] = cells[end_ind];
+        update_stable_id(end_ind, cell);
+        cells.pop_back();
+        if (!links.empty()) {
+            assert(links.size() == cells.size()+1);
+            if (con) { // swapnpop inside the container
+                if (links[cell].valid()) {
+                    int needsupdate = con->swapnpop(links[cell].ijk, links[cell].q);
+                    if (needsupdate > -1) { // we updated q of this element, so we need to update external backrefs to reflect that
+                        links[needsupdate].q = links[cell].q;
+                    }
+                }
+                if (end_ind != cell && links[end_ind].valid()) {
+                    con->id[links[end_ind].ijk][links[end_ind].q] = cell; // update the id of the cell we're swapping back
+                }
+            }
+            links[cell] = links[end_ind];
+            links.pop_back();
+            
+            gl_computed.swapnpop_cell(*this, cell, end_ind);
+        }
+        SANITY("after delete_cell");
+        unsorted_cells++;
+        return true;
+    }
+    
+    // renumbers the cells in morton order of their positions, so cells that are near each other in space are near each other in cells,
+    // links, the gl buffers' per-cell arrays and the sites buffers, and walks over a cell's neighbors (in compute_on, update_site,
+    // export_index_mesh, ...) stay in nearby memory.  worth doing after loading, and after many adds and deletes (see
+    // reorder_if_scattered): new cells go at the end, and delete_cell moves the last cell into the hole.
+    // cell indices from before the call are invalid afterwards (stable ids stay valid), and the whole sites buffer is marked dirty.
+    void reorder_spatially() {
+        gl_flush();
+        int n = int(cells.size());
+        vector<pair<uint32_t, int>> order(n);
+        for (int i=0; i<n; i++) {
+            order[i] = make_pair(morton_key(cells[i].pos, b_min, b_max), i);
+        }
+        sort(order.begin(), order.end());
+        
+        vector<int> new_index(n);
+        vector<Cell> sorted_cells(n);
+        vector<CellConLink> sorted_links(links.size());
+        for (int k=0; k<n; k++) {
+            int i = order[k].second;
+            new_index[i] = k;
+            sorted_cells[k] = cells[i];
+            if (!links.empty()) {
+                sorted_links[k] = links[i];
+            }
+        }
+        cells.swap(sorted_cells);
+        links.swap(sorted_links);
+        if (con) {
+            for (int k=0; k<int(links.size()); k++) {
+                if (links[k].valid()) {
+                    con->id[links[k].ijk][links[k].q] = k;
+                }
+            }
+        }
+        
+        unordered_map<int, size_t> sorted_ids;
+        for (const auto &ci : cell_to_id) {
+            int k = new_index[ci.first];
+            sorted_ids[k] = ci.second;
+            id_to_cell[ci.second] = k;
+        }
+        cell_to_id.swap(sorted_ids);
+        
+        gl_computed.renumber_cells(*this, new_index);
+        unsorted_cells = 0;
+        SANITY("after reorder_spatially");
+    }
+    // calls reorder_spatially if more than the given fraction of the cells have been added or moved by a delete since the last one;
+    // returns whether it did
+    bool reorder_if_scattered(float fraction) {
+        if (unsorted_cells <= fraction*cells.size()) return false;
+        reorder_spatially();
+        return true;
+    }
+    
+    // max threads gl_build may use (0 = all hardware threads, 1 = serial); the result is the same either way
+    void set_build_threads(int num_threads) {
+        gl_computed.build_threads = num_threads;
+    }
+    void gl_build(int max_tris_guess, int max_wire_verts_guess, int max_sites_guess) {
+        // populate gl_computed with current whole voronoi diagram
+        gl_computed.compute_on(*this, max_tris_guess, max_wire_verts_guess, max_sites_guess, has_colors());
+        
+    }
+    // applies all pending edits to the gl buffers; every gl_* read (and anything else that looks at the computed cells) calls this first,
+    // so a batch of edits between reads (e.g. a drag of many cells, or set_fill) recomputes each affected cell just once
+    void gl_flush() {
+        gl_computed.flush(*this);
+    }
+    uintptr_t gl_vertices() {
+        gl_flush();
+        return reinterpret_cast<uintptr_t>(&gl_computed.vertices[0]);
+    }
+    void gl_add_wires(int cell) {
+        gl_flush();
+        gl_computed.add_wires(*this, cell);
+        SANITY("after gl_add_wires");
+    }
+    void gl_clear_wires() {
+        gl_computed.clear_wires();
+    }
+    uintptr_t gl_wire_vertices() {
+        return reinterpret_cast<uintptr_t>(&gl_computed.wire_vertices[0]);
+    }
+    int gl_wire_vert_count() {
+        return gl_computed.wire_vert_count;
+    }
+    int gl_wire_max_verts() {
+        return gl_computed.wire_max_verts;
+    }
+    uintptr_t gl_cell_sites() {
+        gl_flush();
+        return reinterpret_cast<uintptr_t>(&gl_computed.cell_sites[0]);
+    }
+    uintptr_t gl_cell_site_sizes() {
+        gl_flush();
+        return reinterpret_cast<uintptr_t>(&gl_computed.cell_site_sizes[0]);
+    }
+    bool gl_is_live() {
+        return !!gl_computed;
+    }
+    int gl_max_sites() {
+        gl_flush();
+        return gl_computed.max_sites;
+    }
+    int gl_tri_count() { // tris to draw; this includes holes left by edits, which are degenerate (and cell_from_vertex gives -1 for them)
+        gl_flush();
+        return gl_computed.tri_count;
+    }
+    int gl_max_tris() {
+        gl_flush();
+        return gl_computed.max_tris;
+    }
+    // in indexed mode, gl_vertices/gl_colors hold each cell's (exposed) vertices just once, and gl_indices holds 3 vertex indices per tri;
+    // this is about a third of the vertex data of the default 9 floats per tri.  Changing the mode rebuilds the gl buffers if they're live
+    void gl_set_indexed(bool yes_indexed) {
+        if (yes_indexed == gl_computed.indexed) return;
+        gl_computed.indexed = yes_indexed;
+        if (gl_computed) {
+            gl_build(max(gl_computed.max_tris, 1), max(gl_computed.wire_max_verts, 1), gl_computed.max_sites);
+        }
+    }
+    bool gl_is_indexed() {
+        return gl_computed.indexed;
+    }
+    // the parts of the gl buffers that changed since the last gl_clear_dirty, as [start, end) ranges, so the renderer can re-upload
+    // just those: tris (3 entries each of gl_indices, or 3 vertices each of gl_vertices/gl_colors when not indexed), vertices and cell sites
+    GLRange gl_dirty_tri_range() {
+        gl_flush();
+        return gl_computed.dirty_tris;
+    }
+    GLRange gl_dirty_vert_range() {
+        gl_flush();
+        if (!gl_computed.indexed) {
+            return GLRange(gl_computed.dirty_tris.start*3, gl_computed.dirty_tris.end*3);
+        }
+        return gl_computed.dirty_verts;
+    }
+    GLRange gl_dirty_site_range() {
+        gl_flush();
+        return gl_computed.dirty_sites;
+    }
+    void gl_clear_dirty() {
+        gl_computed.clear_dirty();
+    }
+    uintptr_t gl_indices() {
+        gl_flush();
+        if (gl_computed.indices.empty()) return 0;
+        return reinterpret_cast<uintptr_t>(&gl_computed.indices[0]);
+    }
+    int gl_vert_count() { // number of vertices in use in gl_vertices (tri_count*3 when not indexed)
+        gl_flush();
+        return gl_computed.indexed ? gl_computed.vert_count : gl_computed.tri_count*3;
+    }
+    int gl_max_verts() { // number of vertices gl_vertices has room for
+        gl_flush();
+        return gl_computed.indexed ? gl_computed.max_verts : gl_computed.max_tris*3;
+    }
+    int cell_count() {
+        return cells.size();
+    }
+    uintptr_t gl_colors() {
+        gl_flush();
+        return reinterpret_cast<uintptr_t>(&gl_computed.colors[0]);
+    }
+    bool has_colors() {
+        return !palette.empty();
+    }
+    
+    inline glm::vec3 get_color(int type) {
+        assert((type >= 1 && type <= palette.size()) || palette.empty());
+        if (type < 1 || type > palette.size()) {
+            return glm::vec3(1,1,1);
+        } else {
+            return palette[type-1];
+        }
+    }
+    
+    void set_sanity_level(int sanity) {
+        sanity_level = sanity;
+    }
+    void toggle_cell(int cell, int nonzero_type) {
+        if (cell < 0 || cell >= cells.size())
+            return;
+        
+        int oldtype = cells[cell].type;
+        cells[cell].type = oldtype ? 0 : nonzero_type;
+        gl_computed.set_cell(*this, cell, oldtype);
+    }
+    void set_cell(int cell, int type) {
+        if (cell < 0 || cell >= cells.size() || type==cells[cell].type)
+            return;
+        
+        int oldtype = cells[cell].type;
+        cells[cell].type = type;
+        if (cell < gl_computed.info.size()) {
+            gl_computed.set_cell(*this, cell, oldtype);
+        }
+    }
+    int cell_from_vertex(int vert_ind) {
+        gl_flush();
+        return gl_computed.vert2cell(vert_ind);
+    }
+    int cell_neighbor_from_vertex(int vert_ind) {
+        gl_flush();
+        return gl_computed.vert2cell_neighbor(vert_ind);
+    }
+    glm::vec3 cell_pos(int cell) {
+        assert(cell>=0 && cell<cells.size());
+        return cells[cell].pos;
+    }
+    int cell_type(int cell) {
+        assert(cell>=0 && cell<cells.size());
+        return cells[cell].type;
+    }
+    bool cell_affects_shape(int cell) {
+        assert(cell>=0 && cell<cells.size());
+        gl_flush();
+        auto cellType = cells[cell].type;
+        if (gl_computed.info[cell]) {
+            for (auto ni : gl_computed.info[cell]->cache.neighbors) {
+                if (ni >= 0 && cells[ni].type != cellType) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    Cell cell(int c) {
+        assert(c>=0 && c<cells.size());
+        return cells[c];
+    }
+    
+    size_t stable_id(int cell) {
+        if (!cell_to_id.count(cell)) {
+            auto id = tracked_ids++;
+            cell_to_id[cell] = id;
+            id_to_cell[id] = cell;
+        }
+        assert(id_to_cell[cell_to_id[cell]] == cell);
+        return cell_to_id[cell];
+    }
+    // use this to re-associate cells to ids, e.g. if you undo a deletion.
+    // cell and id must both be unmapped when this is called.
+    // id must be one that has already been used (< tracked_ids) so that it will not collide with new ids.
+    void set_stable_id(int cell, size_t id) {
+        // only allow setting id for cells that do not have an id yet
+        assert(!id_to_cell.count(id));
+        assert(!cell_to_id.count(cell));
+        assert(id < tracked_ids);
+        
+        id_to_cell[id] = cell;
+        cell_to_id[cell] = id;
+    }
+    int index_from_id(size_t id) {
+        if (!id_to_cell.count(id)) {
+            return -1;
+        } else {
+            assert(cell_to_id[id_to_cell[id]] == id);
+            return id_to_cell[id];
+        }
+    }
+
+    // exports from gl_computed's cached cells; won't work if there is no cache yet
+    // with full_precision, a COMPACT_CELL_CACHE build recomputes each cell to output its vertices in double precision (otherwise it's a no-op)
+    SimpleIndexMesh export_index_mesh(bool full_precision=false) {
+        gl_flush();
+        SimpleIndexMesh m;
+        
+        double coincidentVertTolerance = 1e-7;
+        
+        vector<vector<pair<int,int>>> cnf; // cnf==CellNeighborFace: cnf[cell_index] = unordered vector of pair<neighbor cell index, index of face in cell that goes to that neighbor>
+        vector<vector<pair<int,int>>> clg; // clg==CellLocalGlobal: clg[cell_index] = unordered vector of pair<local_vertex_index, global_vertex_index>
+        cnf.resize(cells.size());
+        clg.resize(cells.size());
+        
+        auto findPair = [](vector<pair<int, int>> &pairs, int target) {
+            for (int i=0, n=(int)pairs.size(); i<n; i++) {
+                if (pairs[i].first == target) {
+                    return i;
+                }
+            }
+            return -1;
+        };
+        
+        auto getOrAddCNF = [&](int cell, int neighborIndex, int localFaceIndex) {
+            int pairi = findPair(cnf[cell], neighborIndex);
+            if (pairi > -1) {
+                return cnf[cell][pairi].second;
+            }
+            
+            // face not found; add to neighbor a back ref to this cell's face index
+            cnf[neighborIndex].push_back(pair<int,int>(cell, localFaceIndex));
+            return -1;
+        };
+        
+        vector<int> gvp; // global vertex parent indices
+        vector<double> gv; // global vertices (x,y,z)*num_verts
+        
+        auto mergev = [&](int ai, int bi) {
+            if (ai == bi) return; // no merge needed
+            assert(glm::distance2(tovec(gv.data(), ai), tovec(gv.data(), bi)) < coincidentVertTolerance);
+            
+            // find the great grandparent of b
+            int btop = bi;
+            while (gvp[btop] != -1) {
+                btop = gvp[btop];
+            }
+            
+            // set the parent of everything in a to the gp of b
+            int atraverse = ai;
+            while (atraverse != -1) {
+                int nexta = gvp[atraverse];
+                if (atraverse == btop) { // they were already merged ...
+                    return;
+                }
+                gvp[atraverse] = btop;
+                atraverse = nexta;
+            }
+        };
+        
+        auto addVToExisting = [&](int newCell, int newLocalIndex, int oldCell, int oldLocalIndex) {
+            int pairi = findPair(clg[oldCell], oldLocalIndex);
+            assert(pairi > -1);
+            
+            int alreadyMatchedPairi = findPair(clg[newCell], newLocalIndex);
+            if (alreadyMatchedPairi == -1) {
+                clg[newCell].push_back(pair<int,int>(newLocalIndex, clg[oldCell][pairi].second));
+            } else {
+                mergev(clg[newCell][alreadyMatchedPairi].second, clg[oldCell][pairi].second);
+            }
+        };
+        
+        vector<double> precise_v; // the current cell's vertices, recomputed in double precision (if full_precision w/ COMPACT_CELL_CACHE)
+        auto addVNew = [&](int newCell, int newLocalIndex, const ArenaSpan<cache_real> &localv) {
+            for (int ii=0; ii<3; ii++) {
+                gv.push_back(precise_v.empty() ? localv[newLocalIndex*3+ii] : precise_v[newLocalIndex*3+ii]);
+            }
+            clg[newCell].push_back(pair<int,int>(newLocalIndex, (int)gvp.size()));
+            gvp.push_back(-1);
+            assert(gvp.size()*3 == gv.size());
+        };
+        
+        // process:
+        //  1. iterate through cells to build clg and gvp
+        for (size_t ci=0, cn=cells.size(); ci<cn; ci++) {
+            CellCache *cache = gl_computed.get_cache(ci);
+            if (!cache) continue;
+            
+            ArenaSpan<cache_face_int> &lf = cache->faces; // local cell faces
+            ArenaSpan<int> &ln = cache->neighbors; // local cell neighbors
+            ArenaSpan<cache_real> &lv = cache->vertices; // local cell vertices
+            
+            precise_v.clear();
+            if (full_precision && COMPACT_CELL_CACHE && links[ci].valid() &&
+                con->compute_cell(gl_computed.vorocell, links[ci].ijk, links[ci].q)) {
+                int fv_len, nf, nv;
+                gl_computed.cache_arena.face_mesh(gl_computed.vorocell, cells[ci].pos, fv_len, nf, nv); // (numbers the vertices like the cache does)
+                precise_v.assign(gl_computed.cache_arena.tmp_vertices.begin(), gl_computed.cache_arena.tmp_vertices.begin()+nv*3);
+                // the recomputed cell should match the cached one vertex for vertex; if it somehow doesn't, fall back to the cache
+                bool same = precise_v.size() == lv.size();
+                for (size_t vi=0; same && vi<precise_v.size(); vi++) {
+                    same = fabs(precise_v[vi] - lv[vi]) < 1e-4;
+                }
+                if (!same) {
+                    precise_v.clear();
+                }
+            }
+            
+            // A. For each face of cell, add face to mapping and correspond verts for any cells we already processed earlier
+            for (size_t lfi=0, lni=0; lni < ln.size(); lni++, lfi+=lf[lfi]+1) {
+                if (ln[lni] < 0) { // skip if there's no neighbor
+                    continue;
+                }
+                int nlfi = getOrAddCNF(ci, ln[lni], lfi);
+
+                if (nlfi == -1) {
+                    continue; // no matching face found; nothing to merge
+                }
+
+                CellCache *ncache = gl_computed.get_cache(ln[lni]);
+                assert(ncache); // we shouldn't have gotten an nlfi value other than -1 unless nbr cache exists
+                
+                ArenaSpan<cache_face_int> &nlf = ncache->faces;
+                ArenaSpan<cache_real> &nlv = ncache->vertices;
+
+                int faceSize = lf[lfi];
+                glm::vec3 localv = tovec(lv.data(), lf[lfi+1]);
+                if (faceSize != nlf[nlfi]) {
+                    cout << "inconsistent vertex counts in matching faces -- output mesh may not be watertight" << endl;
+                    continue;
+                }
+
+                // we've found a face of the same size in the neighbor cell that corresponds to our face
+                // match our local face's first vertex to one nbr face's vertices
+                int closestPointIndex = -1;
+                double closestPointD2 = 0;
+                int lastBest = -1;
+                bool validMatch = false;
+                // match verts in a do/while so we can rematch in rare cases where the first match is invalid
+                //  -- this happens rarely, usually on (near-)degenerate faces due to rounding error
+                do {
+                    closestPointD2 = 0;
+                    closestPointIndex = -1;
+                    for (int i=lastBest+1; i<faceSize; i++) {
+                        auto nlocalv = tovec(nlv.data(), nlf[nlfi+1+i]);
+                        double d2 = glm::distance2(localv, nlocalv);
+                        if (closestPointIndex == -1 || d2 < closestPointD2) {
+                            closestPointIndex = i;
+                            closestPointD2 = d2;
+                        }
+                    }
+                    lastBest = closestPointIndex;
+                    
+                    validMatch = true;
+                    for (int j=lfi+1, ii=0; ii<faceSize; j++, ii++) {
+                        int oppind = (closestPointIndex-ii + faceSize) % faceSize;
+                        auto vloc = tovec(lv.data(), lf[j]), vnbr = tovec(nlv.data(), nlf[nlfi+1+oppind]);
+                        if (glm::distance2(vloc, vnbr) > coincidentVertTolerance) {
+                            validMatch = false;
+                            break;
+                        }
+                    }
+                } while (!validMatch && lastBest+1<faceSize);
+                
+                if (!validMatch) {
+                    cout << "couldn't connect vertices for a face -- output mesh may not be watertight!" << endl;
+                    continue;
+                }
+                assert (closestPointIndex > -1); // must be true unless a face had zero verts ...
+
+                // correspond all the vertices across the two faces (by traversing them in opposite orders)
+                //  and merge the corresponded vertices
+                for (int j=lfi+1, ii=0; ii<faceSize; j++, ii++) {
+                    int oppind = (closestPointIndex-ii + faceSize) % faceSize;
+                    addVToExisting(ci, lf[j], ln[lni], nlf[nlfi+1+oppind]);
+                }
+            }
+            
+            // B. For each vert in cell that *didn't* have corresponding faces; add its vertices as new ones
+            for (size_t lfi=0, lni=0; lfi<lf.size(); lfi+=lf[lfi]+1, lni++) {
+                for (int lfi_offset=0; lfi_offset<lf[lfi]; lfi_offset++) {
+                    int lvi = lf[lfi+lfi_offset+1];
+                    if (findPair(clg[ci], lvi) == -1) {
+                        addVNew(ci, lvi, lv);
+                    }
+                }
+            }
+        }
+        
+        vector<int> gv2fv(gv.size()/3, -1);
+        vector<double> &fv = m.vertices; // final vertex array
+        
+        auto getFinalIndex = [&](int gvi) {
+            int parenti = gvi;
+            while (gvp[parenti] != -1) {
+                parenti = gvp[parenti];
+            }
+            if (gv2fv[parenti] == -1) {
+                gv2fv[parenti] = fv.size() / 3;
+                fv.push_back(gv[parenti*3]);
+                fv.push_back(gv[parenti*3+1]);
+                fv.push_back(gv[parenti*3+2]);
+            }
+            return gv2fv[parenti];
+        };
+        
+        vector<int> &faces = m.faces; //  final face array
+        
+        //  3. iterate through cells to build global face array w/ indices into final vertex array
+        for (size_t ci=0; ci<cells.size(); ci++) {
+            if (cells[ci].type == 0) continue;
+            CellCache *cache = gl_computed.get_cache(ci);
+            if (!cache) continue;
+            
+            ArenaSpan<cache_face_int> &lf = cache->faces; // local cell faces
+            ArenaSpan<int> &ln = cache->neighbors; // local cell neighbors
+            
+            for (int lfi=0, lni=0; lni < (int)ln.size(); lfi+=lf[lfi]+1, lni++) {
+                int gni = ln[lni]; // global neighbor cell index
+                int nbrType = gni < 0 ? 0 : cells[gni].type;
+                
+                // ignored ADD_ALL_FACES_ALL_THE_TIME flag here; if we want to support that, do it earlier
+                if (nbrType == 0) {
+                    int faceSize = lf[lfi];
+                    faces.push_back(faceSize);
+                    m.palette.push_back(cells[ci].type);
+                    for (int lfi_off=0; lfi_off<faceSize; lfi_off++) {
+                        // note the index to lf is going backwards from lfi+faceSize *down* to lfi+1
+                        //  because voro has faces wound backwards from normal ...
+                        int clg_pair_index = findPair(clg[ci], lf[lfi+faceSize-lfi_off]);
+                        int gvi = clg[ci][clg_pair_index].second;
+                        int fi = getFinalIndex(gvi);
+                        faces.push_back(fi);
+                    }
+                }
+            }
+        }
+        
+        return m;
+    }
+
+
+protected:
+    friend class GLBufferManager;
+    
+    // library user populates the bounds and the cells vector
+    // these define the truth of what the voronoi diagram should be.
+    glm::vec3 b_min, b_max; // bounding box range
+    vector<Cell> cells;
+    vector<glm::vec3> palette;
+    
+    voro::container *con;
+    size_t regrid_at; // cell count at which con gets too crowded and is rebuilt w/ a finer grid (see regrid_container)
+    int sanity_level; // level of error checking.  define "INSANITY" for zero error checking
+    // note: links vector MUST be kept in 1:1, ordered correspondence with the cells vector
+    vector<CellConLink> links; // link cells to container
+    GLBufferManager gl_computed;
+    
+    // this sparse mapping gives stable ids to cells as needed (via the stable_id() function)
+    // use stable ids to track cells externally -- cell indices will change on deletion, but stable ids remain as long as the cell does.
+    unordered_map<int, size_t> cell_to_id;
+    unordered_map<size_t, int> id_to_cell;
+    size_t tracked_ids;
+    size_t unsorted_cells; // cells added, or moved by a delete, since the last reorder_spatially
+    
+    vector<int> js_int_stage; // see js_ints
+    vector<float> js_float_stage; // see js_floats
+    
+    // this puts the old_index into the new_index and removes everything related to what used to be at the new_index
+    void update_stable_id(int old_index, int new_index) {
+        if (cell_to_id.count(new_index)) {
+            auto id_to_remove = cell_to_id[new_index];
+            id_to_cell.erase(id_to_remove);
+            cell_to_id.erase(new_index);
+        }
+        if (cell_to_id.count(old_index)) {
+            auto id = cell_to_id[old_index];
+            cell_to_id.erase(old_index);
+            if (old_index!=new_index) {
+                cell_to_id[new_index] = id;
+                id_to_cell[id] = new_index;
+            }
+        }
+    }
+
+};
+
+#endif